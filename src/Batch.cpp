@@ -0,0 +1,490 @@
+#include "Batch.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace c8emu {
+
+// Allocating space for constexpr symbols
+constexpr std::size_t Batch::maxLanes;
+constexpr std::size_t Batch::maxLead;
+
+namespace {
+using byte = std::uint8_t;
+
+// One byte per lane. With AVX2 a whole row of registers is a single ymm
+// register, otherwise plain loops the compiler is free to vectorize.
+#ifdef __AVX2__
+using Vec = __m256i;
+
+inline Vec vload(byte const *src) {
+  return _mm256_loadu_si256(reinterpret_cast<Vec const *>(src));
+}
+inline void vstore(byte *dst, Vec const v) {
+  _mm256_storeu_si256(reinterpret_cast<Vec *>(dst), v);
+}
+inline Vec set1(byte const val) {
+  return _mm256_set1_epi8(static_cast<char>(val));
+}
+inline Vec add(Vec const a, Vec const b) { return _mm256_add_epi8(a, b); }
+inline Vec sub(Vec const a, Vec const b) { return _mm256_sub_epi8(a, b); }
+inline Vec bor(Vec const a, Vec const b) { return _mm256_or_si256(a, b); }
+inline Vec band(Vec const a, Vec const b) { return _mm256_and_si256(a, b); }
+inline Vec bxor(Vec const a, Vec const b) { return _mm256_xor_si256(a, b); }
+inline Vec eq(Vec const a, Vec const b) { return _mm256_cmpeq_epi8(a, b); }
+// a > b, unsigned
+inline Vec gt(Vec const a, Vec const b) {
+  return bxor(eq(_mm256_max_epu8(b, a), b), set1(0xFF));
+}
+// mask ? a : b
+inline Vec select(Vec const mask, Vec const a, Vec const b) {
+  return _mm256_blendv_epi8(b, a, mask);
+}
+inline Vec shr1(Vec const v) {
+  return band(_mm256_srli_epi16(v, 1), set1(0x7F));
+}
+inline Vec msb(Vec const v) { return band(_mm256_srli_epi16(v, 7), set1(1)); }
+inline Vec shl1(Vec const v) { return _mm256_add_epi8(v, v); }
+inline Vec dec(Vec const v) { return _mm256_subs_epu8(v, set1(1)); }
+#else
+struct Vec {
+  std::array<byte, Batch::maxLanes> v;
+};
+
+template <typename Op> inline Vec apply(Vec const a, Vec const b, Op op) {
+  Vec r;
+  for (std::size_t l = 0; l < Batch::maxLanes; ++l) {
+    r.v[l] = static_cast<byte>(op(a.v[l], b.v[l]));
+  }
+  return r;
+}
+
+inline Vec vload(byte const *src) {
+  Vec r;
+  std::memcpy(r.v.data(), src, r.v.size());
+  return r;
+}
+inline void vstore(byte *dst, Vec const v) {
+  std::memcpy(dst, v.v.data(), v.v.size());
+}
+inline Vec set1(byte const val) {
+  Vec r;
+  r.v.fill(val);
+  return r;
+}
+inline Vec add(Vec const a, Vec const b) {
+  return apply(a, b, [](byte x, byte y) { return x + y; });
+}
+inline Vec sub(Vec const a, Vec const b) {
+  return apply(a, b, [](byte x, byte y) { return x - y; });
+}
+inline Vec bor(Vec const a, Vec const b) {
+  return apply(a, b, [](byte x, byte y) { return x | y; });
+}
+inline Vec band(Vec const a, Vec const b) {
+  return apply(a, b, [](byte x, byte y) { return x & y; });
+}
+inline Vec bxor(Vec const a, Vec const b) {
+  return apply(a, b, [](byte x, byte y) { return x ^ y; });
+}
+inline Vec eq(Vec const a, Vec const b) {
+  return apply(a, b, [](byte x, byte y) { return x == y ? 0xFF : 0; });
+}
+inline Vec gt(Vec const a, Vec const b) {
+  return apply(a, b, [](byte x, byte y) { return x > y ? 0xFF : 0; });
+}
+inline Vec select(Vec const mask, Vec const a, Vec const b) {
+  return bor(band(mask, a), band(bxor(mask, set1(0xFF)), b));
+}
+inline Vec shr1(Vec const v) {
+  return apply(v, v, [](byte x, byte) { return x >> 1; });
+}
+inline Vec msb(Vec const v) {
+  return apply(v, v, [](byte x, byte) { return x >> 7; });
+}
+inline Vec shl1(Vec const v) {
+  return apply(v, v, [](byte x, byte) { return x << 1; });
+}
+inline Vec dec(Vec const v) {
+  return apply(v, v, [](byte x, byte) { return x != 0 ? x - 1 : 0; });
+}
+#endif
+
+inline std::uint64_t rotr(std::uint64_t const v, std::uint32_t const s) {
+  return (v >> s) | (v << ((64 - s) & 63));
+}
+
+inline std::uint32_t popcount(std::uint32_t const v) {
+  return static_cast<std::uint32_t>(__builtin_popcount(v));
+}
+} // namespace
+
+Batch::Batch(std::size_t const lanes)
+    : m_count(lanes), m_lanes(), m_V{}, m_I{}, m_pc{}, m_stack{}, m_sp{},
+      m_opcode{}, m_rand{}, m_status{}, m_delayTimer{}, m_soundTimer{},
+      m_frames{}, m_stats{} {
+  if (lanes == 0 || lanes > maxLanes) {
+    throw std::runtime_error("Invalid lane count");
+  }
+  m_lanes = std::make_unique<Machine[]>(lanes);
+  reset(1);
+}
+
+void Batch::reset(std::uint32_t const seed) {
+  for (std::size_t l = 0; l < m_count; ++l) {
+    m_lanes[l].reset(seed + static_cast<std::uint32_t>(l));
+    setState(l, m_lanes[l].cpu().state());
+    m_frames[l].fill(0);
+  }
+  m_stats = Stats{0, 0, 0, 0};
+}
+
+bool Batch::load(byte const *data, std::size_t const len) {
+  for (std::size_t l = 0; l < m_count; ++l) {
+    if (!m_lanes[l].load(data, len)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Batch::loadGame(std::string const &file) {
+  m_lanes[0].loadGame(file);
+  for (std::size_t l = 1; l < m_count; ++l) {
+    m_lanes[l].memory() = m_lanes[0].memory();
+  }
+}
+
+CPU::State Batch::state(std::size_t const lane) const {
+  CPU::State state;
+
+  state.opcode = m_opcode[lane];
+  for (std::size_t r = 0; r < 16; ++r) {
+    state.registers[r] = m_V[r][lane];
+    state.stack[r] = m_stack[r][lane];
+  }
+  state.I = m_I[lane];
+  state.pc = m_pc[lane];
+  state.sp = m_sp[lane];
+  state.status = m_status[lane];
+  state.rand = m_rand[lane];
+  state.delayTimer = m_delayTimer[lane];
+  state.soundTimer = m_soundTimer[lane];
+  return state;
+}
+
+void Batch::setState(std::size_t const lane, CPU::State const &state) {
+  m_opcode[lane] = state.opcode;
+  for (std::size_t r = 0; r < 16; ++r) {
+    m_V[r][lane] = state.registers[r];
+    m_stack[r][lane] = state.stack[r];
+  }
+  m_I[lane] = state.I;
+  m_pc[lane] = state.pc;
+  m_sp[lane] = state.sp;
+  m_status[lane] = state.status;
+  m_rand[lane] = state.rand;
+  m_delayTimer[lane] = state.delayTimer;
+  m_soundTimer[lane] = state.soundTimer;
+}
+
+void Batch::unpack(std::size_t const lane, GPU &gpu) const {
+  for (std::size_t y = 0; y < 32; ++y) {
+    for (std::size_t x = 0; x < 64; ++x) {
+      gpu.data[y * 64 + x] =
+          static_cast<byte>((m_frames[lane][y] >> (63 - x)) & 1);
+    }
+  }
+  gpu.canDraw = true;
+  gpu.blank = false;
+}
+
+CPU::Status Batch::run(std::size_t const cycles) {
+  // Instructions run by each lane during this call
+  std::array<std::size_t, maxLanes> done{};
+  std::size_t slowest = 0;
+
+  for (;;) {
+    // The lane with the lowest PC leads, so lanes left behind by a branch
+    // catch up with the others before those move on. Lanes too far ahead of
+    // the slowest one wait, or a loop could starve the lanes past its end.
+    // slowest is from the previous issue, faults can leave it behind.
+    std::uint32_t ready = 0;
+    std::size_t lead = maxLanes;
+    std::size_t least = cycles;
+    for (std::size_t l = 0; l < m_count; ++l) {
+      if (m_status[l] != CPU::Status::Ok || done[l] == cycles) {
+        continue;
+      }
+      least = std::min(least, done[l]);
+      if (done[l] < slowest + maxLead) {
+        ready |= 1u << l;
+        lead = lead == maxLanes || m_pc[l] < m_pc[lead] ? l : lead;
+      }
+    }
+    if (least == cycles) {
+      break;
+    }
+    slowest = least;
+    if (ready == 0) {
+      continue;
+    }
+
+    // Lanes at the lead PC about to run the same opcode move together
+    std::uint16_t const opcode = fetch(lead);
+    std::uint32_t group = 0;
+    for (std::size_t l = lead; l < m_count; ++l) {
+      bool const in = ((ready >> l) & 1) != 0 && m_pc[l] == m_pc[lead] &&
+                      fetch(l) == opcode;
+      group |= static_cast<std::uint32_t>(in) << l;
+      done[l] += in ? 1 : 0;
+    }
+
+    if (execVector(opcode, group)) {
+      ++m_stats.vectorIssues;
+      m_stats.vectorLanes += popcount(group);
+    } else {
+      for (std::size_t l = lead; l < m_count; ++l) {
+        if ((group >> l) & 1) {
+          execScalar(l);
+        }
+      }
+      m_stats.scalarLanes += popcount(group);
+    }
+  }
+
+  m_stats.ticks += *std::max_element(done.begin(), done.end());
+  for (std::size_t l = 0; l < m_count; ++l) {
+    if (m_status[l] != CPU::Status::Ok) {
+      return m_status[l];
+    }
+  }
+  return CPU::Status::Ok;
+}
+
+std::uint16_t Batch::fetch(std::size_t const lane) const {
+  std::array<byte, 0x1000> const &mem = m_lanes[lane].memory();
+  return static_cast<std::uint16_t>((mem[m_pc[lane] & 0x0FFF] << 8) |
+                                    mem[(m_pc[lane] + 1) & 0x0FFF]);
+}
+
+// Moves the lane into its scalar CPU for a single instruction
+void Batch::execScalar(std::size_t const lane) {
+  CPU &cpu = m_lanes[lane].cpu();
+
+  cpu.setState(state(lane));
+  cpu.execute();
+  setState(lane, cpu.state());
+}
+
+// Executes an instruction for every lane of the group, mirroring the CPU
+// handlers (including the order in which VF is written). Returns false for
+// instructions left to the scalar CPU: stack, BNNN, key waits, BCD and
+// register dumps, and unknown opcodes.
+bool Batch::execVector(std::uint16_t const opcode, std::uint32_t const group) {
+  std::size_t const x = (opcode & 0x0F00) >> 8;
+  std::size_t const y = (opcode & 0x00F0) >> 4;
+  byte const nn = static_cast<byte>(opcode & 0x00FF);
+  std::uint16_t const nnn = opcode & 0x0FFF;
+
+  Row maskRow;
+  for (std::size_t l = 0; l < maxLanes; ++l) {
+    maskRow[l] = ((group >> l) & 1) != 0 ? 0xFF : 0;
+  }
+  Vec const mask = vload(maskRow.data());
+  Vec const one = set1(1);
+  Vec const ones = set1(0xFF);
+  auto get = [this](std::size_t const r) { return vload(m_V[r].data()); };
+  auto set = [this, &mask, &get](std::size_t const r, Vec const v) {
+    vstore(m_V[r].data(), select(mask, v, get(r)));
+  };
+
+  // Skipping lanes get 2 in their byte, see the PC update below
+  Vec skip = set1(0);
+  bool jump = false;
+
+  switch (opcode >> 12) {
+  case 0x0: // 00E0, the rest goes through the CPU
+    if ((opcode & 0x000F) != 0) {
+      return false;
+    }
+    for (std::size_t l = 0; l < m_count; ++l) {
+      if ((group >> l) & 1) {
+        m_frames[l].fill(0);
+      }
+    }
+    break;
+  case 0x1: // 1NNN
+    jump = true;
+    break;
+  case 0x3: // 3XNN
+    skip = band(eq(get(x), set1(nn)), set1(2));
+    break;
+  case 0x4: // 4XNN
+    skip = band(bxor(eq(get(x), set1(nn)), ones), set1(2));
+    break;
+  case 0x5: // 5XY0
+    skip = band(eq(get(x), get(y)), set1(2));
+    break;
+  case 0x6: // 6XNN
+    set(x, set1(nn));
+    break;
+  case 0x7: // 7XNN
+    set(x, add(get(x), set1(nn)));
+    break;
+  case 0x8:
+    switch (opcode & 0x000F) {
+    case 0x0:
+      set(x, get(y));
+      break;
+    case 0x1:
+      set(x, bor(get(x), get(y)));
+      break;
+    case 0x2:
+      set(x, band(get(x), get(y)));
+      break;
+    case 0x3:
+      set(x, bxor(get(x), get(y)));
+      break;
+    case 0x4: // Carry
+      set(0xF, band(gt(get(y), sub(ones, get(x))), one));
+      set(x, add(get(x), get(y)));
+      break;
+    case 0x5: // No borrow
+      set(0xF, band(bxor(gt(get(y), get(x)), ones), one));
+      set(x, sub(get(x), get(y)));
+      break;
+    case 0x6:
+      set(0xF, band(get(x), one));
+      set(x, shr1(get(x)));
+      break;
+    case 0x7: // No borrow
+      set(0xF, band(bxor(gt(get(x), get(y)), ones), one));
+      set(x, sub(get(y), get(x)));
+      break;
+    case 0xE:
+      set(0xF, msb(get(x)));
+      set(x, shl1(get(x)));
+      break;
+    default:
+      return false;
+    }
+    break;
+  case 0x9: // 9XY0
+    skip = band(bxor(eq(get(x), get(y)), ones), set1(2));
+    break;
+  case 0xA: // ANNN
+    for (std::size_t l = 0; l < maxLanes; ++l) {
+      m_I[l] = ((group >> l) & 1) != 0 ? nnn : m_I[l];
+    }
+    break;
+  case 0xC: // CXNN, xorshift32 like the CPU
+    for (std::size_t l = 0; l < maxLanes; ++l) {
+      std::uint32_t r = m_rand[l];
+      r ^= r << 13;
+      r ^= r >> 17;
+      r ^= r << 5;
+      bool const in = ((group >> l) & 1) != 0;
+      m_rand[l] = in ? r : m_rand[l];
+      m_V[x][l] = in ? static_cast<byte>((r % 0xFF) & nn) : m_V[x][l];
+    }
+    break;
+  case 0xD: // DXYN, on the packed framebuffers
+    for (std::size_t l = 0; l < m_count; ++l) {
+      if ((group >> l) & 1) {
+        drawSprite(l, opcode);
+      }
+    }
+    break;
+  case 0xE: {
+    if (nn != 0x9E && nn != 0xA1) {
+      return false;
+    }
+    Row pressed{};
+    for (std::size_t l = 0; l < m_count; ++l) {
+      pressed[l] = m_lanes[l].keys()[m_V[x][l] & 0xF] ? 0xFF : 0;
+    }
+    Vec const down = vload(pressed.data());
+    skip = band(nn == 0x9E ? down : bxor(down, ones), set1(2));
+    break;
+  }
+  case 0xF:
+    switch (nn) {
+    case 0x07:
+      set(x, vload(m_delayTimer.data()));
+      break;
+    case 0x15:
+      vstore(m_delayTimer.data(),
+            select(mask, get(x), vload(m_delayTimer.data())));
+      break;
+    case 0x18:
+      vstore(m_soundTimer.data(),
+            select(mask, get(x), vload(m_soundTimer.data())));
+      break;
+    case 0x1E:
+      for (std::size_t l = 0; l < m_count; ++l) {
+        if ((group >> l) & 1) {
+          m_V[0xF][l] = m_I[l] + m_V[x][l] > 0xFFF ? 1 : 0;
+          m_I[l] = static_cast<std::uint16_t>(m_I[l] + m_V[x][l]);
+        }
+      }
+      break;
+    case 0x29:
+      for (std::size_t l = 0; l < maxLanes; ++l) {
+        m_I[l] = ((group >> l) & 1) != 0
+                     ? static_cast<std::uint16_t>(m_V[x][l] * 5)
+                     : m_I[l];
+      }
+      break;
+    default:
+      return false;
+    }
+    break;
+  default:
+    return false;
+  }
+
+  // Update PCs and opcodes
+  Row skipRow;
+  vstore(skipRow.data(), skip);
+  for (std::size_t l = 0; l < maxLanes; ++l) {
+    bool const in = ((group >> l) & 1) != 0;
+    std::uint16_t const next =
+        jump ? nnn : static_cast<std::uint16_t>(m_pc[l] + 2 + skipRow[l]);
+    m_pc[l] = in ? next : m_pc[l];
+    m_opcode[l] = in ? opcode : m_opcode[l];
+  }
+
+  // Update timers
+  Vec const delay = vload(m_delayTimer.data());
+  Vec const sound = vload(m_soundTimer.data());
+  vstore(m_delayTimer.data(), select(mask, dec(delay), delay));
+  vstore(m_soundTimer.data(), select(mask, dec(sound), sound));
+  return true;
+}
+
+// Same as CPU::drawSpriteVXVY, one packed row per sprite line
+void Batch::drawSprite(std::size_t const lane, std::uint16_t const opcode) {
+  std::uint32_t const x = m_V[(opcode & 0x0F00) >> 8][lane];
+  std::uint32_t const y = m_V[(opcode & 0x00F0) >> 4][lane];
+  std::uint32_t const height = opcode & 0x000F;
+  std::array<byte, 0x1000> const &mem = m_lanes[lane].memory();
+  std::array<std::uint64_t, 32> &frame = m_frames[lane];
+  byte collision = 0;
+
+  for (std::uint32_t yline = 0; yline < height; ++yline) {
+    std::uint64_t const sprite =
+        rotr(static_cast<std::uint64_t>(mem[(m_I[lane] + yline) & 0x0FFF])
+                 << 56,
+             x & 63);
+    std::uint64_t &row = frame[(y + yline) & 31];
+    collision |= (row & sprite) != 0;
+    row ^= sprite;
+  }
+  m_V[0xF][lane] = collision;
+}
+
+} // namespace c8emu
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CPU.hpp"
+#include "GPU.hpp"
+#include "Machine.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace c8emu {
+// Runs up to 32 copies of a program in lockstep. Registers, I, PC, stack
+// pointer and timers of every lane are stored as structure-of-arrays so that
+// lanes sharing the same PC and opcode execute as one SIMD instruction (AVX2
+// when built with SIMD=avx2). Instructions without a vector implementation
+// fall back to the scalar CPU of the lane. Lanes do not have to stay in step:
+// the lanes at the lowest PC run first, so lanes a branch left behind catch up
+// and merge back with the others, and every lane stops after exactly the
+// requested cycles. Each lane ends up in the same state as a Machine fed with
+// the same seed and keys.
+class Batch {
+  using byte = std::uint8_t;
+
+public:
+  constexpr static std::size_t maxLanes = 32;
+  // How many instructions a lane may run ahead of the slowest one
+  constexpr static std::size_t maxLead = 64;
+
+  struct Stats {
+    std::uint64_t ticks;        // Instructions executed by the lanes
+    std::uint64_t vectorIssues; // Vector instructions issued
+    std::uint64_t vectorLanes;  // Lane instructions executed by vector issues
+    std::uint64_t scalarLanes;  // Lane instructions run by the scalar CPU
+  };
+
+  explicit Batch(std::size_t const lanes);
+
+  Batch(Batch const &) = delete;
+  Batch &operator=(Batch const &) = delete;
+  Batch(Batch &&) = delete;
+  Batch &operator=(Batch &&) = delete;
+
+  // Lane i is seeded with seed + i
+  void reset(std::uint32_t const seed);
+  // Maps the same program in every lane
+  bool load(byte const *data, std::size_t const len);
+  void loadGame(std::string const &file);
+  // Every running lane executes `cycles` instructions, returns the status of
+  // the first faulted lane if any
+  CPU::Status run(std::size_t const cycles);
+
+  inline std::size_t lanes() const { return m_count; }
+  inline std::array<bool, 16> &keys(std::size_t const lane) {
+    return m_lanes[lane].keys();
+  }
+  inline std::array<byte, 0x1000> &memory(std::size_t const lane) {
+    return m_lanes[lane].memory();
+  }
+  inline CPU::Status status(std::size_t const lane) const {
+    return m_status[lane];
+  }
+  // Bit-packed framebuffer of a lane, the MSB of each row is the left pixel
+  inline std::array<std::uint64_t, 32> const &
+  frame(std::size_t const lane) const {
+    return m_frames[lane];
+  }
+  inline Stats const &stats() const { return m_stats; }
+
+  CPU::State state(std::size_t const lane) const;
+  // Expands the packed framebuffer of a lane to the GPU layout
+  void unpack(std::size_t const lane, GPU &gpu) const;
+
+private:
+  using Row = std::array<byte, maxLanes>;
+
+  std::size_t m_count;
+  std::unique_ptr<Machine[]> m_lanes;
+
+  // Lane state, as structure-of-arrays
+  std::array<Row, 16> m_V;
+  std::array<std::uint16_t, maxLanes> m_I;
+  std::array<std::uint16_t, maxLanes> m_pc;
+  std::array<std::array<std::uint16_t, maxLanes>, 16> m_stack;
+  std::array<std::uint16_t, maxLanes> m_sp;
+  std::array<std::uint16_t, maxLanes> m_opcode;
+  std::array<std::uint32_t, maxLanes> m_rand;
+  std::array<CPU::Status, maxLanes> m_status;
+  Row m_delayTimer;
+  Row m_soundTimer;
+
+  // Graphics
+  std::array<std::array<std::uint64_t, 32>, maxLanes> m_frames;
+
+  Stats m_stats;
+
+  void setState(std::size_t const lane, CPU::State const &state);
+  std::uint16_t fetch(std::size_t const lane) const;
+  bool execVector(std::uint16_t const opcode, std::uint32_t const group);
+  void execScalar(std::size_t const lane);
+  void drawSprite(std::size_t const lane, std::uint16_t const opcode);
+};
+} // namespace c8emu
@@ -0,0 +1,100 @@
+#include "Env.hpp"
+#include "c8emu.h"
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+
+// Exceptions must not cross the C boundary, they are turned into a NULL
+// handle and an error message kept per thread
+struct c8emu_env {
+  explicit c8emu_env(std::unique_ptr<c8emu::VecEnv> e) : impl(std::move(e)) {}
+
+  std::unique_ptr<c8emu::VecEnv> impl;
+};
+
+namespace {
+thread_local std::string lastError;
+
+c8emu::EnvConfig convert(c8emu_env_config const *config) {
+  c8emu::EnvConfig result;
+
+  if (config != nullptr) {
+    result.cyclesPerFrame = config->cycles_per_frame;
+    result.frameSkip = config->frame_skip;
+    result.reward.format =
+        static_cast<c8emu::MemoryHook::Format>(config->reward_format);
+    result.reward.address = config->reward_address;
+    result.done.format =
+        static_cast<c8emu::MemoryHook::Format>(config->done_format);
+    result.done.address = config->done_address;
+    result.doneValue = config->done_value;
+    result.threads = config->threads;
+  }
+  return result;
+}
+
+template <typename... Args> c8emu_env *create(Args &&... args) {
+  try {
+    return new c8emu_env(
+        std::make_unique<c8emu::VecEnv>(std::forward<Args>(args)...));
+  } catch (std::exception const &e) {
+    lastError = e.what();
+  }
+  return nullptr;
+}
+} // namespace
+
+extern "C" {
+void c8emu_env_config_init(c8emu_env_config *config) {
+  c8emu::EnvConfig const defaults;
+
+  config->cycles_per_frame = defaults.cyclesPerFrame;
+  config->frame_skip = defaults.frameSkip;
+  config->reward_format = C8EMU_HOOK_NONE;
+  config->reward_address = 0;
+  config->done_format = C8EMU_HOOK_NONE;
+  config->done_address = 0;
+  config->done_value = defaults.doneValue;
+  config->threads = defaults.threads;
+}
+
+c8emu_env *c8emu_env_create(char const *game, size_t count,
+                            c8emu_env_config const *config) {
+  return create(count, std::string(game), convert(config));
+}
+
+c8emu_env *c8emu_env_create_from_memory(uint8_t const *data, size_t len,
+                                        size_t count,
+                                        c8emu_env_config const *config) {
+  return create(count, data, len, convert(config));
+}
+
+void c8emu_env_destroy(c8emu_env *env) { delete env; }
+
+char const *c8emu_last_error(void) { return lastError.c_str(); }
+
+size_t c8emu_env_size(c8emu_env const *env) { return env->impl->size(); }
+
+void c8emu_env_reset(c8emu_env *env, uint32_t seed) { env->impl->reset(seed); }
+
+void c8emu_env_reset_one(c8emu_env *env, size_t index, uint32_t seed) {
+  env->impl->reset(index, seed);
+}
+
+void c8emu_env_step(c8emu_env *env, uint16_t const *actions, size_t frames) {
+  env->impl->step(actions, frames);
+}
+
+float const *c8emu_env_rewards(c8emu_env const *env) {
+  return env->impl->rewards();
+}
+
+uint8_t const *c8emu_env_dones(c8emu_env const *env) {
+  return env->impl->dones();
+}
+
+uint8_t const *c8emu_env_observation(c8emu_env const *env, size_t index) {
+  return env->impl->observation(index);
+}
+}
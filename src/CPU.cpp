@@ -1,50 +1,258 @@
 #include "CPU.hpp"
-#include <iostream>
+#include <algorithm>
 
 namespace c8emu {
+
+// Allocating space for constexpr symbols
+constexpr std::uint32_t CPU::addrMask;
+constexpr std::size_t CPU::coverageSize;
+
 CPU::CPU(std::array<byte, 0x1000> &memory, GPU &gpu,
          std::array<bool, 16> const &keys)
     : m_opcode(0), m_registers{{0}}, m_I(0), m_pc(0x200), m_stack{{0}}, m_sp(0),
-      m_memory(memory), m_delayTimer(0), m_soundTimer(0), m_gpu(gpu),
-      m_keys(keys), m_beepCallback(),
-      m_instHandler{
-          {[this]() { this->opcode0(); }, [this]() { this->jumpTo(); },
-           [this]() { this->callSubroutineAt(); },
-           [this]() { this->skipIfEqualNN(); },
-           [this]() { this->skipIfNotEqualNN(); },
-           [this]() { this->skipIfEqualVY(); }, [this]() { this->setVxToNN(); },
-           [this]() { this->addNNToVX(); }, [this]() { this->opcode8(); },
-           [this]() { this->skipIfNotEqualVY(); },
-           [this]() { this->setIToNNN(); }, [this]() { this->jumpToNNNPlus(); },
-           [this]() { this->setVXRand(); },
-           [this]() { this->drawSpriteVXVY(); }, [this]() { this->opcode13(); },
-           [this]() { this->opcode14(); }}} {}
+      m_status(Status::Ok), m_rand(1), m_memory(memory), m_delayTimer(0),
+      m_soundTimer(0), m_gpu(gpu), m_keys(keys), m_beepCallback(),
+      m_tracer(nullptr), m_coverage(nullptr), m_touched(nullptr),
+      m_touchedCount(0), m_idleSkip(true),
+      m_stats{0, 0, 0},
+      m_instHandler{{&CPU::opcode0, &CPU::jumpTo, &CPU::callSubroutineAt,
+                     &CPU::skipIfEqualNN, &CPU::skipIfNotEqualNN,
+                     &CPU::skipIfEqualVY, &CPU::setVxToNN, &CPU::addNNToVX,
+                     &CPU::opcode8, &CPU::skipIfNotEqualVY, &CPU::setIToNNN,
+                     &CPU::jumpToNNNPlus, &CPU::setVXRand,
+                     &CPU::drawSpriteVXVY, &CPU::opcode13, &CPU::opcode14}} {}
 
 void CPU::setBeepCallback(std::function<void()> const &beepCallback) {
   m_beepCallback = beepCallback;
 }
 
-void CPU::execute() {
-  m_opcode =
-      static_cast<std::uint16_t>((m_memory[m_pc] << 8) | m_memory[m_pc + 1]);
+void CPU::setTracer(TraceWriter *tracer) { m_tracer = tracer; }
+
+void CPU::setCoverage(byte *coverage, std::uint16_t *touched) {
+  m_coverage = coverage;
+  m_touched = touched;
+  m_touchedCount = 0;
+}
+
+void CPU::clearCoverage() {
+  for (std::size_t i = 0; i < m_touchedCount; ++i) {
+    m_coverage[m_touched[i]] = 0;
+  }
+  m_touchedCount = 0;
+}
+
+void CPU::reset(std::uint32_t const seed) {
+  m_opcode = 0;
+  m_registers.fill(0);
+  m_I = 0;
+  m_pc = 0x200;
+  m_stack.fill(0);
+  m_sp = 0;
+  m_status = Status::Ok;
+  m_rand = seed != 0 ? seed : 1; // xorshift must not be seeded with 0
+  m_delayTimer = 0;
+  m_soundTimer = 0;
+  m_stats = Stats{0, 0, 0};
+}
+
+void CPU::setIdleSkip(bool const enabled) { m_idleSkip = enabled; }
+
+CPU::State CPU::state() const {
+  return State{m_opcode, m_registers, m_I,    m_pc,         m_stack,
+               m_sp,     m_status,    m_rand, m_delayTimer, m_soundTimer};
+}
+
+void CPU::setState(State const &state) {
+  m_opcode = state.opcode;
+  m_registers = state.registers;
+  m_I = state.I;
+  m_pc = state.pc;
+  m_stack = state.stack;
+  m_sp = state.sp;
+  m_status = state.status;
+  m_rand = state.rand;
+  m_delayTimer = state.delayTimer;
+  m_soundTimer = state.soundTimer;
+}
+
+void CPU::step() {
+  m_opcode = fetch(m_pc);
 
   // Treat instruction
   byte const opcodeCmp = (m_opcode & 0xF000) / 0x1000;
-  m_instHandler[opcodeCmp]();
+  (this->*m_instHandler[opcodeCmp])();
+}
+
+CPU::Status CPU::run(std::size_t const cycles) {
+  // Traced runs go through execute(), which records every instruction. The
+  // others pick a loop once rather than testing the hooks every instruction.
+  if (m_tracer != nullptr) {
+    for (std::size_t c = 0; c < cycles && m_status == Status::Ok; ++c) {
+      execute();
+    }
+    return m_status;
+  }
+  return m_coverage != nullptr ? runLoop<true>(cycles)
+                               : runLoop<false>(cycles);
+}
+
+template <bool covered> CPU::Status CPU::runLoop(std::size_t cycles) {
+  std::uint64_t executed = 0;
+
+  while (cycles > 0 && m_status == Status::Ok) {
+    // Recognised idle patterns start with a FXNN or 0000 instruction
+    byte const high = memAt(m_pc);
+    if (m_idleSkip && (high >= 0xF0 || high == 0)) {
+      std::size_t const elided = skipIdle(cycles);
+      if (elided != 0) {
+        cycles -= elided;
+        continue;
+      }
+    }
 
-  // Update timers
-  if (m_delayTimer > 0) {
-    --m_delayTimer;
+    std::uint16_t const pc = m_pc;
+    step();
+    if (covered) {
+      bump(pc, m_opcode);
+    }
+    ++executed;
+    tick();
+    --cycles;
+  }
+  m_stats.executed += executed;
+  return m_status;
+}
+
+// Recognises the ways programs wait for time to pass and fast-forwards them
+// in a single step. Returns the number of cycles elided, the resulting state
+// is the same as if they had been executed one by one.
+std::size_t CPU::skipIdle(std::size_t const budget) {
+  std::uint16_t const opcode = fetch(m_pc);
+  std::size_t const x = (opcode & 0x0F00) >> 8;
+
+  if (opcode == 0x0000 && m_gpu.blank) {
+    // Zeroed memory, decoded as 00E0: once the screen is blank each of them
+    // only moves on to the next word, the whole run is crossed at once
+    std::size_t count = 0;
+    while (count < budget && fetch(m_pc) == 0x0000) {
+      cover(m_pc, 0x0000, 1);
+      m_pc = static_cast<std::uint16_t>(m_pc + 2);
+      ++count;
+    }
+    m_opcode = 0x0000;
+    m_gpu.canDraw = true;
+    m_stats.frames += count;
+    elapse(count);
+    m_stats.elided += count;
+    return count;
   }
 
+  if ((opcode & 0xF0FF) == 0xF00A) {
+    // FX0A with no key down: only the timers change until a key is pressed,
+    // and keys don't change during a batch
+    for (bool const key : m_keys) {
+      if (key) {
+        return 0;
+      }
+    }
+    m_opcode = opcode;
+    cover(m_pc, opcode, budget);
+    elapse(budget);
+    m_stats.elided += budget;
+    return budget;
+  }
+
+  // FX07 / 3X00 / 1NNN (jumping back to FX07): spin until the delay timer
+  // reaches 0. As timers tick every instruction, each loop reads a value 3
+  // lower than the previous one.
+  std::uint16_t const skip = static_cast<std::uint16_t>(0x3000 | (x << 8));
+  std::uint16_t const jump = static_cast<std::uint16_t>(0x1000 | m_pc);
+  if ((opcode & 0xF0FF) != 0xF007 || m_pc > addrMask || m_delayTimer == 0 ||
+      fetch(m_pc + 2u) != skip || fetch(m_pc + 4u) != jump) {
+    return 0;
+  }
+
+  std::size_t const loops =
+      std::min<std::size_t>((m_delayTimer + 2u) / 3u, budget / 3);
+  if (loops == 0) {
+    return 0;
+  }
+  m_registers[x] = static_cast<byte>(m_delayTimer - 3 * (loops - 1));
+  m_opcode = jump;
+  cover(m_pc, opcode, loops);
+  cover(static_cast<std::uint16_t>(m_pc + 2), skip, loops);
+  cover(static_cast<std::uint16_t>(m_pc + 4), jump, loops);
+  elapse(loops * 3);
+  m_stats.elided += loops * 3;
+  return loops * 3;
+}
+
+// Ticks the timers as if `cycles` instructions had been executed
+void CPU::elapse(std::size_t const cycles) {
+  m_delayTimer =
+      cycles >= m_delayTimer ? 0 : static_cast<byte>(m_delayTimer - cycles);
+
   if (m_soundTimer > 0) {
-    if (m_soundTimer == 1) {
-      m_beepCallback();
+    if (cycles >= m_soundTimer) {
+      if (m_beepCallback) {
+        m_beepCallback();
+      }
+      m_soundTimer = 0;
+    } else {
+      m_soundTimer = static_cast<byte>(m_soundTimer - cycles);
     }
-    --m_soundTimer;
   }
 }
 
+void CPU::cover(std::uint16_t const pc, std::uint16_t const opcode,
+                std::size_t const count) {
+  if (m_coverage != nullptr) {
+    std::size_t const index = coverageIndex(pc, opcode);
+    if (m_coverage[index] == 0 && m_touched != nullptr) {
+      m_touched[m_touchedCount++] = static_cast<std::uint16_t>(index);
+    }
+    m_coverage[index] = static_cast<byte>(
+        std::min<std::size_t>(0xFF, m_coverage[index] + count));
+  }
+}
+
+CPU::Status CPU::execute() {
+  // A faulted CPU stays halted
+  if (m_status != Status::Ok) {
+    return m_status;
+  }
+
+  std::uint16_t const pc = m_pc;
+  if (m_tracer != nullptr) {
+    std::array<byte, 16> const registers = m_registers;
+    step();
+    m_tracer->record(pc, m_opcode, m_I, registers, m_registers);
+  } else {
+    step();
+  }
+
+  if (m_coverage != nullptr) {
+    bump(pc, m_opcode);
+  }
+  ++m_stats.executed;
+  tick();
+  return m_status;
+}
+
+char const *CPU::statusString(Status const status) {
+  switch (status) {
+  case Status::Ok:
+    return "Ok";
+  case Status::StackOverflow:
+    return "Stack overflow";
+  case Status::StackUnderflow:
+    return "Stack underflow";
+  case Status::IllegalOpcode:
+    return "Unknown opcode";
+  }
+  return "Unknown status";
+}
+
 void CPU::opcode0() {
   switch (m_opcode & 0x000F) {
   case 0x0000: // 0x00E0: Clears the screen
@@ -55,7 +263,7 @@ void CPU::opcode0() {
     returnFromSubroutine();
     break;
   default:
-    throw std::runtime_error("Unknown opcode.");
+    m_status = Status::IllegalOpcode;
   }
 }
 void CPU::opcode8() {
@@ -104,7 +312,7 @@ void CPU::opcode8() {
     break;
 
   default:
-    throw std::runtime_error("Unknown opcode");
+    m_status = Status::IllegalOpcode;
   }
 }
 void CPU::opcode13() {
@@ -120,7 +328,7 @@ void CPU::opcode13() {
     break;
 
   default:
-    throw std::runtime_error("Unknown opcode");
+    m_status = Status::IllegalOpcode;
   }
 }
 void CPU::opcode14() {
@@ -168,17 +376,26 @@ void CPU::opcode14() {
     break;
 
   default:
-    throw std::runtime_error("Unknown opcode.");
+    m_status = Status::IllegalOpcode;
   }
 }
 
 void CPU::clearScreen() {
-  m_gpu.data.fill(0);
+  // Programs running into zeroed memory clear a blank screen over and over
+  if (!m_gpu.blank) {
+    m_gpu.data.fill(0);
+    m_gpu.blank = true;
+  }
   m_gpu.canDraw = true;
+  ++m_stats.frames;
   m_pc += 2;
 }
 
 void CPU::returnFromSubroutine() {
+  if (m_sp == 0) {
+    m_status = Status::StackUnderflow;
+    return;
+  }
   --m_sp;
   m_pc = m_stack[m_sp] + 2;
 }
@@ -186,6 +403,10 @@ void CPU::returnFromSubroutine() {
 void CPU::jumpTo() { m_pc = m_opcode & 0x0FFF; }
 
 void CPU::callSubroutineAt() {
+  if (m_sp == m_stack.size()) {
+    m_status = Status::StackOverflow;
+    return;
+  }
   m_stack[m_sp] = m_pc;
   ++m_sp;
   m_pc = m_opcode & 0x0FFF;
@@ -235,11 +456,14 @@ void CPU::setIToNNN() {
   m_pc += 2;
 }
 
-void CPU::jumpToNNNPlus() { m_pc = (m_opcode & 0x0FFF) + m_registers[0]; }
+void CPU::jumpToNNNPlus() {
+  m_pc = static_cast<std::uint16_t>(((m_opcode & 0x0FFF) + m_registers[0]) &
+                                   addrMask);
+}
 
 void CPU::setVXRand() {
   m_registers[(m_opcode & 0x0F00) >> 8] =
-      (std::rand() % 0xFF) & (m_opcode & 0x00FF);
+      (nextRand() % 0xFF) & (m_opcode & 0x00FF);
   m_pc += 2;
 }
 
@@ -320,31 +544,35 @@ void CPU::drawSpriteVXVY() {
 
   m_registers[0xF] = 0;
   for (std::size_t yline = 0; yline < height; yline++) {
-    pixel = m_memory[m_I + yline];
+    pixel = memAt(m_I + yline);
     for (std::size_t xline = 0; xline < 8; xline++) {
       if ((pixel & (0x80 >> xline)) != 0) {
-        if (m_gpu.data[(x + xline + ((y + yline) * 64))] == 1) {
+        // Sprites wrap around the edges of the screen
+        std::size_t const pos = ((x + xline) & 63) + ((y + yline) & 31) * 64;
+        if (m_gpu.data[pos] == 1) {
           m_registers[0xF] = 1;
         }
-        m_gpu.data[x + xline + ((y + yline) * 64)] ^= 1;
+        m_gpu.data[pos] ^= 1;
       }
     }
   }
 
   m_gpu.canDraw = true;
+  m_gpu.blank = m_gpu.blank && height == 0;
+  ++m_stats.frames;
   m_pc += 2;
 }
 
 void CPU::skipIfVXPressed() {
   m_pc += 2;
-  if (m_keys[m_registers[(m_opcode & 0x0F00) >> 8]] != 0) {
+  if (m_keys[m_registers[(m_opcode & 0x0F00) >> 8] & 0xF] != 0) {
     m_pc += 2;
   }
 }
 
 void CPU::skipIfVXNotPressed() {
   m_pc += 2;
-  if (m_keys[m_registers[(m_opcode & 0x0F00) >> 8]] == 0) {
+  if (m_keys[m_registers[(m_opcode & 0x0F00) >> 8] & 0xF] == 0) {
     m_pc += 2;
   }
 }
@@ -398,15 +626,15 @@ void CPU::setIToSprite() {
 }
 
 void CPU::storeBinVXInI() {
-  m_memory[m_I] = m_registers[(m_opcode & 0x0F00) >> 8] / 100;
-  m_memory[m_I + 1] = (m_registers[(m_opcode & 0x0F00) >> 8] / 10) % 10;
-  m_memory[m_I + 2] = (m_registers[(m_opcode & 0x0F00) >> 8] % 100) % 10;
+  memAt(m_I) = m_registers[(m_opcode & 0x0F00) >> 8] / 100;
+  memAt(m_I + 1u) = (m_registers[(m_opcode & 0x0F00) >> 8] / 10) % 10;
+  memAt(m_I + 2u) = (m_registers[(m_opcode & 0x0F00) >> 8] % 100) % 10;
   m_pc += 2;
 }
 
 void CPU::storeRegistersToMemAtI() {
   for (std::size_t i = 0; i <= ((m_opcode & 0x0F00) >> 8); ++i) {
-    m_memory[m_I + i] = m_registers[i];
+    memAt(m_I + i) = m_registers[i];
   }
 
   // On the original interpreter, when the operation is done, I = I + X +
@@ -417,7 +645,7 @@ void CPU::storeRegistersToMemAtI() {
 
 void CPU::fillRegistersWithMemAtI() {
   for (std::size_t i = 0; i <= ((m_opcode & 0x0F00) >> 8); ++i) {
-    m_registers[i] = m_memory[m_I + i];
+    m_registers[i] = memAt(m_I + i);
   }
 
   // On the original interpreter, when the operation is done, I = I + X +
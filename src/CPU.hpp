@@ -1,7 +1,9 @@
 #pragma once
 
 #include "GPU.hpp"
+#include "Trace.hpp"
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 
@@ -10,10 +12,62 @@ class CPU {
   using byte = std::uint8_t;
 
 public:
+  // Faults are reported through status codes, a faulted CPU halts until it
+  // is reset
+  enum class Status : std::uint8_t {
+    Ok,
+    StackOverflow,
+    StackUnderflow,
+    IllegalOpcode
+  };
+
+  struct Stats {
+    std::uint64_t executed; // Instructions actually interpreted
+    std::uint64_t elided;   // Cycles fast-forwarded by the idle loop detection
+    std::uint64_t frames;   // Framebuffer updates (00E0 and DXYN)
+  };
+
+  // Architectural state, used to move a machine in and out of the CPU
+  struct State {
+    std::uint16_t opcode;
+    std::array<byte, 16> registers;
+    std::uint16_t I;
+    std::uint16_t pc;
+    std::array<std::uint16_t, 16> stack;
+    std::uint16_t sp;
+    Status status;
+    std::uint32_t rand;
+    byte delayTimer;
+    byte soundTimer;
+  };
+
+  // Size of the PC/opcode coverage bitmap, see setCoverage()
+  constexpr static std::size_t coverageSize = 1 << 15;
+
   explicit CPU(std::array<byte, 0x1000> &m_memory, GPU &gpu,
                std::array<bool, 16> const &keys);
   void setBeepCallback(std::function<void()> const &beepCallback);
-  void execute();
+  void setTracer(TraceWriter *tracer);
+  // Every executed instruction bumps a saturating counter indexed by its PC
+  // and opcode group. The bitmap must hold coverageSize bytes. When given,
+  // `touched` (coverageSize entries too) lists the counters which left 0, so
+  // that a run can be merged and cleared without scanning the whole bitmap.
+  void setCoverage(byte *coverage, std::uint16_t *touched = nullptr);
+  inline std::size_t touchedCount() const { return m_touchedCount; }
+  // Zeroes the touched counters, only valid with a touched list
+  void clearCoverage();
+  // run() fast-forwards delay timer busy-waits, key waits and runs through
+  // zeroed memory, on by default
+  void setIdleSkip(bool const enabled);
+  void reset(std::uint32_t const seed);
+  Status execute();
+  Status run(std::size_t const cycles);
+
+  inline Stats const &stats() const { return m_stats; }
+  State state() const;
+  void setState(State const &state);
+
+  static char const *statusString(Status const status);
 
   CPU(CPU const &) = delete;
   CPU &operator=(CPU const &) = delete;
@@ -27,6 +81,8 @@ private:
   std::uint16_t m_pc;
   std::array<std::uint16_t, 16> m_stack;
   std::uint16_t m_sp;
+  Status m_status;
+  std::uint32_t m_rand;
   std::array<byte, 0x1000> &m_memory;
 
   // APU
@@ -40,8 +96,74 @@ private:
   std::array<bool, 16> const &m_keys;
   std::function<void()> m_beepCallback;
 
+  // Debug
+  TraceWriter *m_tracer;
+  byte *m_coverage;
+  std::uint16_t *m_touched;
+  std::size_t m_touchedCount;
+
+  // Profiling
+  bool m_idleSkip;
+  Stats m_stats;
+
   // Instructions
-  std::array<std::function<void()>, 34> m_instHandler;
+  std::array<void (CPU::*)(), 16> m_instHandler;
+
+  // The address space is 12 bits wide, every access wraps around
+  constexpr static std::uint32_t addrMask = 0x0FFF;
+
+  inline byte &memAt(std::size_t const addr) {
+    return m_memory[addr & addrMask];
+  }
+
+  // Instructions are (nearly always) word aligned, so the bitmap is indexed
+  // by the PC word and the instruction group (upper nibble of the opcode)
+  inline static std::size_t coverageIndex(std::uint16_t const pc,
+                                          std::uint16_t const opcode) {
+    return static_cast<std::size_t>(((pc & addrMask) >> 1) << 4) |
+           (opcode >> 12);
+  }
+
+  // xorshift32, keeps the machine deterministic for a given seed
+  inline std::uint32_t nextRand() {
+    m_rand ^= m_rand << 13;
+    m_rand ^= m_rand >> 17;
+    m_rand ^= m_rand << 5;
+    return m_rand;
+  }
+
+  inline std::uint16_t fetch(std::size_t const addr) {
+    return static_cast<std::uint16_t>((memAt(addr) << 8) | memAt(addr + 1));
+  }
+
+  inline void bump(std::uint16_t const pc, std::uint16_t const opcode) {
+    std::size_t const index = coverageIndex(pc, opcode);
+    byte &hits = m_coverage[index];
+    if (hits == 0 && m_touched != nullptr) {
+      m_touched[m_touchedCount++] = static_cast<std::uint16_t>(index);
+    }
+    hits = static_cast<byte>(hits + (hits != 0xFF));
+  }
+
+  // Timers tick once per instruction
+  inline void tick() {
+    if (m_delayTimer > 0) {
+      --m_delayTimer;
+    }
+    if (m_soundTimer > 0) {
+      if (m_soundTimer == 1 && m_beepCallback) {
+        m_beepCallback();
+      }
+      --m_soundTimer;
+    }
+  }
+
+  void step();
+  template <bool covered> Status runLoop(std::size_t cycles);
+  std::size_t skipIdle(std::size_t const budget);
+  void elapse(std::size_t const cycles);
+  void cover(std::uint16_t const pc, std::uint16_t const opcode,
+             std::size_t const count);
 
   void opcode0();
   void opcode8();
@@ -1,67 +1,121 @@
 #include "Chip8.hpp"
-#include <fstream>
+#include "Screen.hpp"
+#include "Terminal.hpp"
+#include <ctime>
 #include <iostream>
-#include <sstream>
+#include <stdexcept>
 
 namespace c8emu {
 
 // Allocating space for constexpr symbols
 constexpr std::uint32_t Chip8::screenWidth;
 constexpr std::uint32_t Chip8::screenHeight;
-constexpr std::array<std::uint8_t, 80> Chip8::fontset;
-
-Chip8::Chip8()
-    : m_memory{}, m_gpu{{{0}}, true}, m_cpu(m_memory, m_gpu, m_keys), m_keys{},
-      m_screen(screenWidth, screenHeight, m_gpu.data, m_keys, 20) {
-  for (std::size_t i = 0; i < 80; ++i)
-    m_memory[i] = fontset[i];
-  std::srand(static_cast<std::uint32_t>(std::time(nullptr)));
-  m_cpu.setBeepCallback([&]() { m_screen.beep(); });
+
+Chip8::Chip8(Display const display)
+    : m_machine(), m_telemetry(), m_frontend(), m_tracer(), m_shared(),
+      m_origin(), m_reportStartup(false) {
+  if (display == Display::Terminal) {
+    m_frontend =
+        std::make_unique<Terminal>(m_machine.gpu().data, m_machine.keys());
+  } else {
+    m_frontend = std::make_unique<Screen>(screenWidth, screenHeight,
+                                          m_machine.gpu().data,
+                                          m_machine.keys(), 20);
+  }
+  m_machine.reset(static_cast<std::uint32_t>(std::time(nullptr)));
+  m_machine.cpu().setBeepCallback([&]() { m_frontend->beep(); });
+  m_frontend->setTelemetry(m_telemetry);
 }
 
-void Chip8::loadGame(std::string const &file) {
-  // Open file
-  std::ifstream input(file, std::ifstream::ate | std::ios::binary);
+void Chip8::loadGame(std::string const &file) { m_machine.loadGame(file); }
 
-  if (!input.is_open()) {
-    throw std::runtime_error("Cannot open file: " + file);
-  }
+void Chip8::trace(std::string const &file) {
+  m_tracer = std::make_unique<TraceWriter>(file);
+  m_machine.cpu().setTracer(m_tracer.get());
+}
 
-  // Get size of the file, allocate the buffer and go back to the beginning
-  // of the file
-  std::size_t len = static_cast<std::size_t>(input.tellg());
-  if (m_memory.max_size() - 512 <= len) {
-    throw std::runtime_error("Invalid file size"); // TODO: real exception
-  }
-  std::unique_ptr<byte[]> data = std::make_unique<byte[]>(len);
-  input.seekg(0, std::ios::beg);
-
-  // Load file into the buffer
-  std::stringstream ss;
-  ss << input.rdbuf();
-  ss.read(reinterpret_cast<char *>(data.get()),
-          static_cast<std::streamsize>(len));
-
-  // Memory map the game
-  for (std::size_t i = 0; i < len; ++i) {
-    m_memory[i + 512] = data[i];
-  }
+void Chip8::share(std::string const &name) {
+  m_shared = std::make_unique<SharedState>(name);
+}
+
+void Chip8::reportStartup(std::chrono::steady_clock::time_point const origin) {
+  m_origin = origin;
+  m_reportStartup = true;
 }
 
 void Chip8::play() {
-  m_screen.beep(); // TODO: rm
-  while (m_screen.isOpen()) {
+  using clock = Telemetry::clock;
+  CPU &cpu = m_machine.cpu();
+
+  // Startup report, the first frame comes with the window
+  bool pendingReport = m_reportStartup;
+  clock::time_point const ready = clock::now();
+  clock::time_point firstInstruction;
+
+  // The blank screen left by reset() is not presented, the window opens with
+  // the first 00E0 or DXYN
+  m_machine.gpu().canDraw = false;
+
+  while (m_frontend->isOpen()) {
+    bool const sampled = m_telemetry.sampling();
+    clock::time_point start = sampled ? clock::now() : clock::time_point();
+
     // Single cpu step
-    m_cpu.execute();
+    CPU::Status const status = cpu.execute();
+    if (status != CPU::Status::Ok) {
+      throw std::runtime_error(CPU::statusString(status));
+    }
+    if (pendingReport && firstInstruction == clock::time_point()) {
+      firstInstruction = clock::now();
+    }
+    if (sampled) {
+      clock::time_point const now = clock::now();
+      m_telemetry.addTime(Telemetry::Phase::Execute,
+                          (now - start) * Telemetry::samplePeriod);
+      start = now;
+    }
 
     // Update drawing when needed
-    if (m_gpu.canDraw) {
-      m_screen.gpuExec();
+    if (m_machine.gpu().canDraw) {
+      clock::time_point const drawStart = clock::now();
+      m_frontend->gpuExec();
+      clock::time_point const drawEnd = clock::now();
+      m_telemetry.addTime(Telemetry::Phase::GpuExec, drawEnd - drawStart);
+      start = drawEnd;
+      if (pendingReport) {
+        printStartup(ready, firstInstruction, drawEnd);
+        pendingReport = false;
+      }
+
+      m_machine.gpu().canDraw = false;
+      if (m_shared) {
+        m_shared->publish(m_machine.gpu(), cpu.state(), m_machine.keys());
+      }
     }
 
     // Capture inputs
-    m_screen.getInputs();
+    m_frontend->getInputs();
+    if (m_shared) {
+      m_shared->applyKeys(m_machine.keys());
+    }
+    if (sampled) {
+      clock::time_point const now = clock::now();
+      m_telemetry.addTime(Telemetry::Phase::GetInputs,
+                          (now - start) * Telemetry::samplePeriod);
+      m_telemetry.update(now, cpu.stats());
+    }
   }
 }
 
+void Chip8::printStartup(Telemetry::clock::time_point const ready,
+                         Telemetry::clock::time_point const instruction,
+                         Telemetry::clock::time_point const frame) const {
+  auto const ms = [this](Telemetry::clock::time_point const t) {
+    return std::chrono::duration<double, std::milli>(t - m_origin).count();
+  };
+  std::cerr << "ready:             " << ms(ready) << "ms" << std::endl
+            << "first instruction: " << ms(instruction) << "ms" << std::endl
+            << "first frame:       " << ms(frame) << "ms" << std::endl;
+}
+
 } // namespace c8emu
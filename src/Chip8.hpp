@@ -1,22 +1,24 @@
 #pragma once
 
-#include "CPU.hpp"
-#include "GPU.hpp"
-#include "Screen.hpp"
-#include <array>
+#include "Frontend.hpp"
+#include "Machine.hpp"
+#include "SharedState.hpp"
+#include "Telemetry.hpp"
+#include "Trace.hpp"
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
 
 namespace c8emu {
 class Chip8 {
-  using byte = std::uint8_t;
-
 public:
   constexpr static std::uint32_t screenWidth = 64;
   constexpr static std::uint32_t screenHeight = 32;
 
-  Chip8();
+  enum class Display : std::uint8_t { Window, Terminal };
+
+  explicit Chip8(Display const display);
 
   Chip8(Chip8 const &) = delete;
   Chip8 &operator=(Chip8 const &) = delete;
@@ -24,36 +26,29 @@ public:
   Chip8 &operator=(Chip8 &&) = delete;
 
   void loadGame(std::string const &file);
+  void trace(std::string const &file);
+  // Publishes every presented frame in a shared memory segment
+  void share(std::string const &name);
+  // Prints the time from `origin` to the first instruction and the first
+  // frame once they happened
+  void reportStartup(std::chrono::steady_clock::time_point const origin);
   void play();
 
 private:
-  std::array<byte, 0x1000> m_memory;
-  GPU m_gpu;
-  CPU m_cpu;
-
-  // IO
-  std::array<bool, 16> m_keys;
+  Machine m_machine;
+  Telemetry m_telemetry;
 
   // Display
-  Screen m_screen;
-
-  constexpr static std::array<byte, 80> const fontset = {{
-      0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-      0x20, 0x60, 0x20, 0x20, 0x70, // 1
-      0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-      0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-      0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-      0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-      0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-      0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-      0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-      0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-      0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-      0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-      0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-      0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-      0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-      0xF0, 0x80, 0xF0, 0x80, 0x80  // F
-  }};
+  std::unique_ptr<Frontend> m_frontend;
+
+  // Debug
+  std::unique_ptr<TraceWriter> m_tracer;
+  std::unique_ptr<SharedState> m_shared;
+  std::chrono::steady_clock::time_point m_origin;
+  bool m_reportStartup;
+
+  void printStartup(Telemetry::clock::time_point const ready,
+                    Telemetry::clock::time_point const instruction,
+                    Telemetry::clock::time_point const frame) const;
 };
 } // namespace c8emu
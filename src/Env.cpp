@@ -0,0 +1,112 @@
+#include "Env.hpp"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace c8emu {
+namespace {
+std::vector<std::uint8_t> readGame(std::string const &file) {
+  std::ifstream input(file, std::ios::binary);
+
+  if (!input.is_open()) {
+    throw std::runtime_error("Cannot open file: " + file);
+  }
+  return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(input),
+                                   std::istreambuf_iterator<char>());
+}
+} // namespace
+
+VecEnv::VecEnv(std::size_t const count, std::string const &game,
+               EnvConfig const &config)
+    : VecEnv(count, readGame(game), config) {}
+
+VecEnv::VecEnv(std::size_t const count, byte const *data,
+               std::size_t const len, EnvConfig const &config)
+    : VecEnv(count, std::vector<byte>(data, data + len), config) {}
+
+VecEnv::VecEnv(std::size_t const count, std::vector<byte> game,
+               EnvConfig const &config)
+    : m_count(count), m_config(config), m_game(std::move(game)),
+      m_machines(std::make_unique<Machine[]>(count)), m_pool(config.threads),
+      m_rewards(count, 0), m_dones(count, 0), m_scores(count, 0) {
+  if (m_game.size() >= 0x1000 - Machine::programStart) {
+    throw std::runtime_error("Invalid file size");
+  }
+  reset(0);
+}
+
+void VecEnv::reset(std::uint32_t const seed) {
+  m_pool.parallelFor(m_count, [this, seed](std::size_t const env) {
+    this->reset(env, seed + static_cast<std::uint32_t>(env));
+  });
+}
+
+void VecEnv::reset(std::size_t const env, std::uint32_t const seed) {
+  Machine &machine = m_machines[env];
+
+  machine.reset(seed);
+  machine.load(m_game.data(), m_game.size());
+  m_rewards[env] = 0;
+  m_dones[env] = 0;
+  m_scores[env] = read(env, m_config.reward);
+}
+
+void VecEnv::step(std::uint16_t const *actions, std::size_t const frames) {
+  std::size_t const total = frames * m_config.frameSkip;
+
+  m_pool.parallelFor(m_count, [this, actions, total](std::size_t const env) {
+    this->stepOne(env, actions[env], total);
+  });
+}
+
+void VecEnv::stepOne(std::size_t const env, std::uint16_t const action,
+                     std::size_t const frames) {
+  Machine &machine = m_machines[env];
+
+  m_rewards[env] = 0;
+  if (m_dones[env] != 0) {
+    return;
+  }
+
+  std::array<bool, 16> &keys = machine.keys();
+  for (std::size_t k = 0; k < keys.size(); ++k) {
+    keys[k] = ((action >> k) & 1) != 0;
+  }
+
+  for (std::size_t f = 0; f < frames; ++f) {
+    if (machine.run(m_config.cyclesPerFrame) != CPU::Status::Ok ||
+        isDone(env)) {
+      m_dones[env] = 1;
+      break;
+    }
+  }
+
+  std::uint32_t const score = read(env, m_config.reward);
+  m_rewards[env] =
+      static_cast<float>(score) - static_cast<float>(m_scores[env]);
+  m_scores[env] = score;
+}
+
+std::uint32_t VecEnv::read(std::size_t const env,
+                           MemoryHook const &hook) const {
+  std::array<byte, 0x1000> const &memory = m_machines[env].memory();
+  std::size_t const at = hook.address & 0x0FFF;
+
+  switch (hook.format) {
+  case MemoryHook::Format::None:
+    return 0;
+  case MemoryHook::Format::Byte:
+    return memory[at];
+  case MemoryHook::Format::BCD:
+    return memory[at] * 100u + memory[(at + 1) & 0x0FFF] * 10u +
+           memory[(at + 2) & 0x0FFF];
+  }
+  return 0;
+}
+
+bool VecEnv::isDone(std::size_t const env) const {
+  return m_config.done.format != MemoryHook::Format::None &&
+         read(env, m_config.done) == m_config.doneValue;
+}
+} // namespace c8emu
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Machine.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace c8emu {
+// Reads a game variable from memory, used to derive rewards and episode ends
+struct MemoryHook {
+  enum class Format : std::uint8_t {
+    None, // Hook disabled
+    Byte, // Single byte at address
+    BCD   // Three digits written by FX33, hundreds at address
+  };
+
+  Format format = Format::None;
+  std::uint16_t address = 0;
+};
+
+struct EnvConfig {
+  std::size_t cyclesPerFrame = 10; // Instructions per emulated frame
+  std::size_t frameSkip = 1;       // Frames an action is repeated for
+  MemoryHook reward;               // Reward is the increase of this value
+  MemoryHook done;                 // Episode ends when it reads doneValue
+  std::uint32_t doneValue = 0;
+  std::size_t threads = 0; // 0 uses one thread per hardware thread
+};
+
+// A vector of environments running the same game, stepped in parallel. An
+// action is the bit mask of the keys held during the step. Observations point
+// straight to the framebuffer of each Machine, they stay valid for the lifetime
+// of the environment and are updated in place by step().
+class VecEnv {
+  using byte = std::uint8_t;
+
+public:
+  VecEnv(std::size_t const count, std::string const &game,
+         EnvConfig const &config);
+  VecEnv(std::size_t const count, byte const *data, std::size_t const len,
+         EnvConfig const &config);
+
+  VecEnv(VecEnv const &) = delete;
+  VecEnv &operator=(VecEnv const &) = delete;
+  VecEnv(VecEnv &&) = delete;
+  VecEnv &operator=(VecEnv &&) = delete;
+
+  // Environment i is seeded with seed + i
+  void reset(std::uint32_t const seed);
+  void reset(std::size_t const env, std::uint32_t const seed);
+  // Runs `frames` * frameSkip frames on every environment which is not done
+  void step(std::uint16_t const *actions, std::size_t const frames);
+
+  inline std::size_t size() const { return m_count; }
+  inline float const *rewards() const { return m_rewards.data(); }
+  inline byte const *dones() const { return m_dones.data(); }
+  // 64x32 bytes, one per pixel, in the GPU layout
+  inline byte const *observation(std::size_t const env) const {
+    return m_machines[env].gpu().data.data();
+  }
+  inline Machine &machine(std::size_t const env) { return m_machines[env]; }
+
+private:
+  std::size_t m_count;
+  EnvConfig m_config;
+  std::vector<byte> m_game;
+  std::unique_ptr<Machine[]> m_machines;
+  ThreadPool m_pool;
+
+  // Per environment results of the last step
+  std::vector<float> m_rewards;
+  std::vector<byte> m_dones;
+  std::vector<std::uint32_t> m_scores;
+
+  VecEnv(std::size_t const count, std::vector<byte> game,
+         EnvConfig const &config);
+
+  void stepOne(std::size_t const env, std::uint16_t const action,
+               std::size_t const frames);
+  std::uint32_t read(std::size_t const env, MemoryHook const &hook) const;
+  bool isDone(std::size_t const env) const;
+};
+} // namespace c8emu
@@ -0,0 +1,8 @@
+#include "Frontend.hpp"
+
+namespace c8emu {
+// Out of line so the vtable is emitted once
+Frontend::~Frontend() = default;
+
+void Frontend::setTelemetry(Telemetry &) {}
+} // namespace c8emu
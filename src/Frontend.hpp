@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Telemetry.hpp"
+
+namespace c8emu {
+// What Chip8::play() drives: shows the framebuffer, feeds the keypad and
+// plays the beep
+class Frontend {
+public:
+  Frontend() = default;
+  virtual ~Frontend();
+
+  Frontend(Frontend const &) = delete;
+  Frontend &operator=(Frontend const &) = delete;
+  Frontend(Frontend &&) = delete;
+  Frontend &operator=(Frontend &&) = delete;
+
+  virtual bool isOpen() const = 0;
+  virtual void gpuExec() = 0;
+  virtual void getInputs() = 0;
+  virtual void beep() = 0;
+  // Frontends record the frames they actually show, and may display the
+  // counters. The default ignores it.
+  virtual void setTelemetry(Telemetry &telemetry);
+};
+} // namespace c8emu
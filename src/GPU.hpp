@@ -7,5 +7,6 @@ namespace c8emu {
 struct GPU {
   std::array<std::uint8_t, 0x800> data;
   bool canDraw;
+  bool blank; // Set while data is known to be all zeros
 };
 } // namespace c8emu
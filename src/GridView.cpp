@@ -0,0 +1,190 @@
+#include "GridView.hpp"
+#include "Screen.hpp"
+#include <algorithm>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+
+namespace c8emu {
+namespace {
+// Windows are made about this wide, whatever the number of columns
+constexpr std::size_t windowWidth = 1280;
+
+constexpr std::array<sf::Uint8, 4> background = {{40, 40, 40, 255}};
+constexpr std::array<sf::Uint8, 4> pixelOff = {{0, 0, 0, 255}};
+constexpr std::array<sf::Uint8, 4> pixelOn = {{255, 255, 255, 255}};
+constexpr std::array<sf::Uint8, 4> focusOff = {{0, 20, 60, 255}};
+constexpr std::array<sf::Uint8, 4> focusOn = {{255, 200, 60, 255}};
+constexpr std::array<sf::Uint8, 4> faultOff = {{70, 0, 0, 255}};
+} // namespace
+
+// Allocating space for constexpr symbols
+constexpr std::size_t GridView::cyclesPerFrame;
+constexpr std::size_t GridView::tileWidth;
+constexpr std::size_t GridView::tileHeight;
+constexpr std::size_t GridView::gap;
+
+GridView::GridView(std::size_t const columns, std::size_t const rows)
+    : m_columns(columns), m_rows(rows), m_count(columns * rows),
+      m_machines(), m_atlasWidth(columns * (tileWidth + gap) + gap),
+      m_atlasHeight(rows * (tileHeight + gap) + gap), m_pix(), m_dirty(),
+      m_faulted(), m_win(), m_atlas(), m_sprite(), m_focus(0) {
+  if (m_count == 0) {
+    throw std::runtime_error("Invalid grid size");
+  }
+  // Checked on the tile counts, the atlas size itself may have overflowed
+  std::size_t const maxSize = sf::Texture::getMaximumSize();
+  if (columns > (maxSize - gap) / (tileWidth + gap) ||
+      rows > (maxSize - gap) / (tileHeight + gap)) {
+    throw std::runtime_error("Grid too large, textures are limited to " +
+                             std::to_string(maxSize) + " pixels");
+  }
+  m_machines = std::make_unique<Machine[]>(m_count);
+  m_dirty.assign(m_count, true);
+  m_faulted.assign(m_count, false);
+
+  std::uint32_t const seed = static_cast<std::uint32_t>(std::time(nullptr));
+  for (std::size_t t = 0; t < m_count; ++t) {
+    m_machines[t].reset(seed + static_cast<std::uint32_t>(t));
+  }
+
+  m_pix.resize(m_atlasWidth * m_atlasHeight * 4);
+  for (std::size_t p = 0; p < m_pix.size(); p += 4) {
+    std::copy(background.begin(), background.end(), &m_pix[p]);
+  }
+
+  std::size_t const scale =
+      std::max<std::size_t>(1, windowWidth / m_atlasWidth);
+  m_win.create(
+      sf::VideoMode(static_cast<unsigned int>(m_atlasWidth * scale),
+                    static_cast<unsigned int>(m_atlasHeight * scale)),
+      "Chip8 Emulator");
+  if (!m_win.isOpen()) {
+    throw std::runtime_error("Cannot create SFML window");
+  }
+  m_win.setFramerateLimit(60);
+  m_atlas.create(static_cast<unsigned int>(m_atlasWidth),
+                 static_cast<unsigned int>(m_atlasHeight));
+  m_atlas.update(m_pix.data()); // Gaps are only uploaded here
+  m_sprite.setTexture(m_atlas);
+  m_sprite.setScale(static_cast<float>(scale), static_cast<float>(scale));
+}
+
+void GridView::loadGame(std::string const &file) {
+  m_machines[0].loadGame(file);
+  for (std::size_t t = 1; t < m_count; ++t) {
+    m_machines[t].memory() = m_machines[0].memory();
+  }
+}
+
+void GridView::play() {
+  while (m_win.isOpen()) {
+    for (std::size_t t = 0; t < m_count; ++t) {
+      // A faulted machine halts, run() returns right away
+      Machine &machine = m_machines[t];
+      if (machine.run(cyclesPerFrame) != CPU::Status::Ok && !m_faulted[t]) {
+        m_faulted[t] = true;
+        m_dirty[t] = true;
+      }
+      if (machine.gpu().canDraw) {
+        machine.gpu().canDraw = false;
+        m_dirty[t] = true;
+      }
+    }
+
+    // Dirty tiles are repacked, then the rows of the atlas they span are
+    // uploaded in one go
+    std::size_t first = m_rows;
+    std::size_t last = 0;
+    for (std::size_t t = 0; t < m_count; ++t) {
+      if (m_dirty[t]) {
+        pack(t);
+        m_dirty[t] = false;
+        first = std::min(first, t / m_columns);
+        last = t / m_columns;
+      }
+    }
+    if (first != m_rows) {
+      std::size_t const top = first * (tileHeight + gap) + gap;
+      std::size_t const height = (last - first + 1) * (tileHeight + gap) - gap;
+      m_atlas.update(&m_pix[top * m_atlasWidth * 4],
+                     static_cast<unsigned int>(m_atlasWidth),
+                     static_cast<unsigned int>(height), 0,
+                     static_cast<unsigned int>(top));
+    }
+
+    m_win.clear();
+    m_win.draw(m_sprite);
+    m_win.display();
+
+    getInputs();
+  }
+}
+
+// Copies the framebuffer of a machine to its place in the atlas
+void GridView::pack(std::size_t const tile) {
+  std::array<std::uint8_t, 0x800> const &gfx = m_machines[tile].gpu().data;
+  Color const &on = tile == m_focus ? focusOn : pixelOn;
+  Color const &off =
+      m_faulted[tile] ? faultOff : (tile == m_focus ? focusOff : pixelOff);
+  std::size_t const x0 = (tile % m_columns) * (tileWidth + gap) + gap;
+  std::size_t const y0 = (tile / m_columns) * (tileHeight + gap) + gap;
+
+  for (std::size_t y = 0; y < tileHeight; ++y) {
+    sf::Uint8 *row = &m_pix[((y0 + y) * m_atlasWidth + x0) * 4];
+    for (std::size_t x = 0; x < tileWidth; ++x) {
+      Color const &color = gfx[y * tileWidth + x] != 0 ? on : off;
+      std::copy(color.begin(), color.end(), row + x * 4);
+    }
+  }
+}
+
+void GridView::focus(std::size_t const tile) {
+  // Keys held on the previous tile would otherwise stay down
+  m_machines[m_focus].keys().fill(false);
+  m_dirty[m_focus] = true;
+  m_focus = tile;
+  m_dirty[m_focus] = true;
+}
+
+void GridView::getInputs() {
+  sf::Event event;
+  while (m_win.pollEvent(event)) {
+    if (event.type == sf::Event::Closed) {
+      m_win.close();
+    } else if (event.type == sf::Event::KeyPressed) {
+      std::size_t const column = m_focus % m_columns;
+      std::size_t const row = m_focus / m_columns;
+      switch (event.key.code) {
+      case sf::Keyboard::Escape:
+        m_win.close();
+        break;
+      case sf::Keyboard::Tab:
+        focus((m_focus + (event.key.shift ? m_count - 1 : 1)) % m_count);
+        break;
+      case sf::Keyboard::Left:
+        focus(row * m_columns + (column + m_columns - 1) % m_columns);
+        break;
+      case sf::Keyboard::Right:
+        focus(row * m_columns + (column + 1) % m_columns);
+        break;
+      case sf::Keyboard::Up:
+        focus(((row + m_rows - 1) % m_rows) * m_columns + column);
+        break;
+      case sf::Keyboard::Down:
+        focus(((row + 1) % m_rows) * m_columns + column);
+        break;
+      }
+      int const key = Screen::keyOf(event.key.code);
+      if (key >= 0) {
+        m_machines[m_focus].keys()[static_cast<std::size_t>(key)] = true;
+      }
+    } else if (event.type == sf::Event::KeyReleased) {
+      int const key = Screen::keyOf(event.key.code);
+      if (key >= 0) {
+        m_machines[m_focus].keys()[static_cast<std::size_t>(key)] = false;
+      }
+    }
+  }
+}
+} // namespace c8emu
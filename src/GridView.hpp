@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Machine.hpp"
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace c8emu {
+// Runs a grid of machines on the same game in one window. Every tile lives in
+// a single texture atlas, only the tiles whose machine drew something are
+// repacked, and the rows of the atlas holding them are uploaded once and drawn
+// with one sprite per frame. Keys go to the focused tile, which Tab /
+// Shift+Tab and the arrows move around.
+class GridView {
+  using Color = std::array<sf::Uint8, 4>;
+
+public:
+  // Instructions run by every machine between two displayed frames
+  constexpr static std::size_t cyclesPerFrame = 1024;
+  constexpr static std::size_t tileWidth = 64;
+  constexpr static std::size_t tileHeight = 32;
+  constexpr static std::size_t gap = 1; // Pixels between tiles
+
+  GridView(std::size_t const columns, std::size_t const rows);
+
+  GridView(GridView const &) = delete;
+  GridView &operator=(GridView const &) = delete;
+  GridView(GridView &&) = delete;
+  GridView &operator=(GridView &&) = delete;
+
+  void loadGame(std::string const &file);
+  void play();
+
+private:
+  std::size_t m_columns;
+  std::size_t m_rows;
+  std::size_t m_count;
+  std::unique_ptr<Machine[]> m_machines;
+
+  // Display
+  std::size_t m_atlasWidth;
+  std::size_t m_atlasHeight;
+  std::vector<sf::Uint8> m_pix;
+  std::vector<bool> m_dirty;
+  std::vector<bool> m_faulted;
+  sf::RenderWindow m_win;
+  sf::Texture m_atlas;
+  sf::Sprite m_sprite;
+
+  // IO
+  std::size_t m_focus;
+
+  void pack(std::size_t const tile);
+  void focus(std::size_t const tile);
+  void getInputs();
+};
+} // namespace c8emu
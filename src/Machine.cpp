@@ -0,0 +1,66 @@
+#include "Machine.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace c8emu {
+
+// Allocating space for constexpr symbols
+constexpr std::size_t Machine::programStart;
+constexpr std::array<std::uint8_t, 80> Machine::fontset;
+
+Machine::Machine()
+    : m_memory{}, m_gpu{{{0}}, true, true}, m_cpu(m_memory, m_gpu, m_keys),
+      m_keys{} {
+  reset(1);
+}
+
+void Machine::reset(std::uint32_t const seed) {
+  std::memset(m_memory.data(), 0, m_memory.size());
+  std::copy(fontset.begin(), fontset.end(), m_memory.begin());
+  std::memset(m_gpu.data.data(), 0, m_gpu.data.size());
+  m_gpu.canDraw = true;
+  m_gpu.blank = true;
+  m_keys.fill(false);
+  m_cpu.reset(seed);
+}
+
+bool Machine::load(byte const *data, std::size_t const len) {
+  if (m_memory.size() - programStart <= len) {
+    return false;
+  }
+  std::copy(data, data + len, m_memory.begin() + programStart);
+  return true;
+}
+
+void Machine::loadGame(std::string const &file) {
+  // Open file
+  std::ifstream input(file, std::ifstream::ate | std::ios::binary);
+
+  if (!input.is_open()) {
+    throw std::runtime_error("Cannot open file: " + file);
+  }
+
+  // Get size of the file, allocate the buffer and go back to the beginning
+  // of the file
+  std::size_t len = static_cast<std::size_t>(input.tellg());
+  if (m_memory.max_size() - programStart <= len) {
+    throw std::runtime_error("Invalid file size"); // TODO: real exception
+  }
+  std::unique_ptr<byte[]> data = std::make_unique<byte[]>(len);
+  input.seekg(0, std::ios::beg);
+
+  // Load file into the buffer
+  std::stringstream ss;
+  ss << input.rdbuf();
+  ss.read(reinterpret_cast<char *>(data.get()),
+          static_cast<std::streamsize>(len));
+
+  // Memory map the game
+  load(data.get(), len);
+}
+
+} // namespace c8emu
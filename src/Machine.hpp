@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CPU.hpp"
+#include "GPU.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace c8emu {
+// Headless CHIP-8: memory, framebuffer, keypad and CPU, without any frontend.
+// A Machine is meant to be reused, reset() brings it back to its power-on
+// state without reallocating anything.
+class Machine {
+  using byte = std::uint8_t;
+
+public:
+  // First address available to programs
+  constexpr static std::size_t programStart = 0x200;
+
+  Machine();
+
+  Machine(Machine const &) = delete;
+  Machine &operator=(Machine const &) = delete;
+  Machine(Machine &&) = delete;
+  Machine &operator=(Machine &&) = delete;
+
+  void reset(std::uint32_t const seed);
+  // Maps a program at 0x200, returns false when it doesn't fit in memory
+  bool load(byte const *data, std::size_t const len);
+  void loadGame(std::string const &file);
+  inline CPU::Status run(std::size_t const cycles) { return m_cpu.run(cycles); }
+
+  inline std::array<byte, 0x1000> &memory() { return m_memory; }
+  inline GPU &gpu() { return m_gpu; }
+  inline std::array<bool, 16> &keys() { return m_keys; }
+  inline CPU &cpu() { return m_cpu; }
+
+private:
+  std::array<byte, 0x1000> m_memory;
+  GPU m_gpu;
+  CPU m_cpu;
+
+  // IO
+  std::array<bool, 16> m_keys;
+
+  constexpr static std::array<byte, 80> const fontset = {{
+      0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+      0x20, 0x60, 0x20, 0x20, 0x70, // 1
+      0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+      0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+      0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+      0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+      0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+      0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+      0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+      0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+      0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+      0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+      0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+      0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+      0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+      0xF0, 0x80, 0xF0, 0x80, 0x80  // F
+  }};
+};
+} // namespace c8emu
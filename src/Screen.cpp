@@ -1,54 +1,117 @@
 #include "Screen.hpp"
-#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
 
 namespace c8emu {
+namespace {
+constexpr std::size_t beepSamples = 44100 / 8;
+constexpr std::uint32_t beepRate = 44100;
+constexpr double beepAmplitude = 30000;
+// 660Hz, the angle step of each sample
+constexpr double beepStep = 6.28318 * (440. * 1.5) / 44100;
+
+// Taylor series, only used on the small step angle
+constexpr double sine(double const x) {
+  return x - x * x * x / 6 + x * x * x * x * x / 120 -
+         x * x * x * x * x * x * x / 5040;
+}
+
+constexpr double cosine(double const x) {
+  return 1 - x * x / 2 + x * x * x * x / 24 - x * x * x * x * x * x / 720;
+}
+
+struct Waveform {
+  sf::Int16 samples[beepSamples];
+};
+
+// The sine is obtained by rotating a unit vector by the step angle, which
+// stays cheap enough to be evaluated by the compiler
+constexpr Waveform makeBeep() {
+  Waveform wave{};
+  double const c = cosine(beepStep);
+  double const s = sine(beepStep);
+  double re = 1;
+  double im = 0;
+
+  for (std::size_t i = 0; i < beepSamples; ++i) {
+    wave.samples[i] = static_cast<sf::Int16>(beepAmplitude * im);
+    double const next = re * c - im * s;
+    im = re * s + im * c;
+    re = next;
+  }
+  return wave;
+}
+
+constexpr Waveform beepWave = makeBeep();
+} // namespace
+
+// Allocating space for constexpr symbols
+constexpr std::chrono::milliseconds Screen::windowDelay;
+
 Screen::Screen(std::uint32_t const width, std::uint32_t const height,
                std::array<std::uint8_t, 64 * 32> const &gfx,
                std::array<bool, 16> &keys, std::uint8_t const scaleFactor)
-    : m_width(width), m_height(height),
-      m_win(sf::VideoMode(m_width * scaleFactor, m_height * scaleFactor),
-            "Chip8 Emulator"),
-      m_texture(), m_sprite(),
+    : m_width(width), m_height(height), m_scale(scaleFactor), m_created(false),
+      m_windowDeadline(std::chrono::steady_clock::now() + windowDelay),
+      m_polls(0), m_win(), m_texture(), m_sprite(),
       m_pix(std::make_unique<sf::Uint8[]>(m_width * m_height * 4)), m_gfx(gfx),
-      m_keys(keys), m_soundBuff(), m_beep() {
+      m_keys(keys), m_soundBuff(), m_beep(),
+      m_audio(std::async(std::launch::async, [this]() { loadBeep(); })),
+      m_muted(false),
+      m_telemetry(nullptr), m_overlay(false), m_titleSample(0) {}
+
+void Screen::create() {
+  m_win.create(sf::VideoMode(m_width * m_scale, m_height * m_scale),
+               "Chip8 Emulator");
   if (!m_win.isOpen()) {
     throw std::runtime_error(
         "Cannot create SFML window"); // TODO: Real exception
   }
   m_texture.create(m_width, m_height);
   m_sprite.setTexture(m_texture);
-  m_sprite.setScale(static_cast<float>(scaleFactor),
-                    static_cast<float>(scaleFactor));
-
-  loadBeep();
+  m_sprite.setScale(static_cast<float>(m_scale), static_cast<float>(m_scale));
+  m_created = true;
 }
 
 void Screen::loadBeep() {
-  std::uint32_t const samples = 44100 / 8;
-  std::uint32_t const rate = 44100;
-  std::uint32_t const amplitude = 30000;
-  sf::Int16 raw[samples];
-  double const twoPI = 6.28318;
-  double const increment = (440. * 1.5) / 44100;
-  double x = 0;
-
-  // Fill array
-  for (std::uint32_t i = 0; i < samples; i++) {
-    raw[i] = static_cast<sf::Int16>(amplitude * std::sin(x * twoPI));
-    x += increment;
-  }
-
-  // Load sound
-  if (!m_soundBuff.loadFromSamples(raw, samples, 1, rate)) {
+  m_soundBuff = std::make_unique<sf::SoundBuffer>();
+  if (!m_soundBuff->loadFromSamples(beepWave.samples, beepSamples, 1,
+                                    beepRate)) {
     throw std::runtime_error("Cannot load sounds");
   }
 
-  m_beep.setBuffer(m_soundBuff);
+  m_beep = std::make_unique<sf::Sound>(*m_soundBuff);
 }
 
-void Screen::beep() { m_beep.play(); }
+void Screen::beep() {
+  if (m_audio.valid()) {
+    if (m_audio.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      return;
+    }
+    try {
+      m_audio.get();
+    } catch (std::exception const &e) {
+      std::cerr << e.what() << ", audio disabled" << std::endl;
+      m_muted = true;
+    }
+  }
+  if (!m_muted) {
+    m_beep->play();
+  }
+}
+
+void Screen::setTelemetry(Telemetry &telemetry) {
+  m_telemetry = &telemetry;
+}
 
 void Screen::gpuExec() {
+  if (!m_created) {
+    create();
+  }
   m_win.clear();
   for (std::uint32_t y = 0; y < m_height; ++y) {
     for (std::uint32_t x = 0; x < m_width; ++x) {
@@ -64,10 +127,110 @@ void Screen::gpuExec() {
   }
   m_texture.update(m_pix.get());
   m_win.draw(m_sprite);
+  if (m_overlay && m_telemetry != nullptr) {
+    drawOverlay();
+  }
   m_win.display();
+  if (m_telemetry != nullptr) {
+    m_telemetry->presented(Telemetry::clock::now());
+  }
+}
+
+// Frame time bars (p50 then p99, the mark is the 60Hz budget) and the share of
+// host time spent in execute(), gpuExec() and getInputs(). The figures go to
+// the title bar, as there is no font to draw them with.
+void Screen::drawOverlay() {
+  Telemetry::Sample const &sample = m_telemetry->last();
+  float const pxPerMs = 6.f;
+  float const budget = 1000.f / 60.f;
+  auto const rect = [this](float const x, float const y, float const w,
+                           float const h, sf::Color const color) {
+    sf::RectangleShape shape(sf::Vector2f(w, h));
+    shape.setPosition(x, y);
+    shape.setFillColor(color);
+    m_win.draw(shape);
+  };
+
+  if (m_telemetry->samples() != m_titleSample) {
+    char title[128];
+    std::snprintf(title, sizeof(title),
+                  "Chip8 Emulator - %llu fps, frame p50 %.1fms p99 %.1fms",
+                  static_cast<unsigned long long>(sample.presentedFrames),
+                  sample.frameP50, sample.frameP99);
+    m_win.setTitle(title);
+    m_titleSample = m_telemetry->samples();
+  }
+
+  rect(10, 10, 220, 55, sf::Color(0, 0, 0, 160));
+  rect(20, 15, std::min(static_cast<float>(sample.frameP50) * pxPerMs, 200.f),
+       10, sf::Color(0, 200, 0));
+  rect(20, 30, std::min(static_cast<float>(sample.frameP99) * pxPerMs, 200.f),
+       10,
+       sample.frameP99 > static_cast<double>(budget) ? sf::Color(220, 0, 0)
+                                                     : sf::Color(220, 200, 0));
+  rect(20 + budget * pxPerMs, 13, 1, 29, sf::Color(255, 255, 255));
+
+  std::array<sf::Color, Telemetry::phaseCount> const colors = {
+      {sf::Color(0, 120, 255), sf::Color(200, 0, 200), sf::Color(255, 140, 0)}};
+  float x = 20;
+  for (std::size_t p = 0; p < Telemetry::phaseCount; ++p) {
+    float const w = static_cast<float>(sample.phases[p]) * 2.f;
+    rect(x, 48, w, 10, colors[p]);
+    x += w;
+  }
+}
+
+int Screen::keyOf(sf::Keyboard::Key const key) {
+  switch (key) {
+  case sf::Keyboard::Num1:
+    return 0x1;
+  case sf::Keyboard::Num2:
+    return 0x2;
+  case sf::Keyboard::Num3:
+    return 0x3;
+  case sf::Keyboard::Num4:
+    return 0xC;
+
+  case sf::Keyboard::Q:
+    return 0x4;
+  case sf::Keyboard::W:
+    return 0x5;
+  case sf::Keyboard::E:
+    return 0x6;
+  case sf::Keyboard::R:
+    return 0xD;
+
+  case sf::Keyboard::A:
+    return 0x7;
+  case sf::Keyboard::S:
+    return 0x8;
+  case sf::Keyboard::D:
+    return 0x9;
+  case sf::Keyboard::F:
+    return 0xE;
+
+  case sf::Keyboard::Z:
+    return 0xA;
+  case sf::Keyboard::X:
+    return 0x0;
+  case sf::Keyboard::C:
+    return 0xB;
+  case sf::Keyboard::V:
+    return 0xF;
+  }
+  return -1;
 }
 
 void Screen::getInputs() {
+  if (!m_created) {
+    // Shows the blank screen, so that keys can reach a game waiting for one
+    if ((++m_polls & 0xFF) == 0 &&
+        std::chrono::steady_clock::now() >= m_windowDeadline) {
+      gpuExec();
+    }
+    return;
+  }
+
   sf::Event event;
   while (m_win.pollEvent(event)) {
 
@@ -79,111 +242,22 @@ void Screen::getInputs() {
       case sf::Keyboard::Escape:
         m_win.close();
         break;
-      case sf::Keyboard::Num1:
-        m_keys[0x1] = true;
-        break;
-      case sf::Keyboard::Num2:
-        m_keys[0x2] = true;
-        break;
-      case sf::Keyboard::Num3:
-        m_keys[0x3] = true;
-        break;
-      case sf::Keyboard::Num4:
-        m_keys[0xC] = true;
-        break;
-
-      case sf::Keyboard::Q:
-        m_keys[0x4] = true;
-        break;
-      case sf::Keyboard::W:
-        m_keys[0x5] = true;
-        break;
-      case sf::Keyboard::E:
-        m_keys[0x6] = true;
-        break;
-      case sf::Keyboard::R:
-        m_keys[0xD] = true;
-        break;
-
-      case sf::Keyboard::A:
-        m_keys[0x7] = true;
-        break;
-      case sf::Keyboard::S:
-        m_keys[0x8] = true;
-        break;
-      case sf::Keyboard::D:
-        m_keys[0x9] = true;
-        break;
-      case sf::Keyboard::F:
-        m_keys[0xE] = true;
-        break;
-
-      case sf::Keyboard::Z:
-        m_keys[0xA] = true;
-        break;
-      case sf::Keyboard::X:
-        m_keys[0x0] = true;
-        break;
-      case sf::Keyboard::C:
-        m_keys[0xB] = true;
-        break;
-      case sf::Keyboard::V:
-        m_keys[0xF] = true;
+      case sf::Keyboard::F1:
+        m_overlay = !m_overlay;
+        if (!m_overlay) {
+          m_win.setTitle("Chip8 Emulator");
+          m_titleSample = 0;
+        }
         break;
       }
+      int const key = keyOf(event.key.code);
+      if (key >= 0) {
+        m_keys[static_cast<std::size_t>(key)] = true;
+      }
     } else if (event.type == sf::Event::KeyReleased) {
-      switch (event.key.code) {
-      case sf::Keyboard::Num1:
-        m_keys[0x1] = false;
-        break;
-      case sf::Keyboard::Num2:
-        m_keys[0x2] = false;
-        break;
-      case sf::Keyboard::Num3:
-        m_keys[0x3] = false;
-        break;
-      case sf::Keyboard::Num4:
-        m_keys[0xC] = false;
-        break;
-
-      case sf::Keyboard::Q:
-        m_keys[0x4] = false;
-        break;
-      case sf::Keyboard::W:
-        m_keys[0x5] = false;
-        break;
-      case sf::Keyboard::E:
-        m_keys[0x6] = false;
-        break;
-      case sf::Keyboard::R:
-        m_keys[0xD] = false;
-        break;
-
-      case sf::Keyboard::A:
-        m_keys[0x7] = false;
-        break;
-      case sf::Keyboard::S:
-        m_keys[0x8] = false;
-        break;
-      case sf::Keyboard::D:
-        m_keys[0x9] = false;
-        break;
-      case sf::Keyboard::F:
-        m_keys[0xE] = false;
-        break;
-
-      case sf::Keyboard::Z:
-        m_keys[0xA] = false;
-        break;
-      case sf::Keyboard::X:
-        m_keys[0x0] = false;
-        break;
-      case sf::Keyboard::C:
-        m_keys[0xB] = false;
-        break;
-      case sf::Keyboard::V:
-        m_keys[0xF] = false;
-        break;
+      int const key = keyOf(event.key.code);
+      if (key >= 0) {
+        m_keys[static_cast<std::size_t>(key)] = false;
       }
     }
   }
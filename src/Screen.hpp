@@ -1,40 +1,70 @@
 #pragma once
 
+#include "Frontend.hpp"
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
 #include <array>
+#include <chrono>
+#include <future>
+#include <memory>
 
 namespace c8emu {
-class Screen {
+// SFML frontend. Nothing slow happens at construction: the window is opened
+// with the first frame, or once windowDelay has passed for games which wait
+// for a key before drawing. The audio device is set up in the background,
+// beeps are dropped until it is ready, or for good if it fails.
+class Screen : public Frontend {
 public:
+  constexpr static std::chrono::milliseconds windowDelay{200};
+
   Screen(std::uint32_t const width, std::uint32_t const height,
          std::array<std::uint8_t, 0x800> const &gfx, std::array<bool, 16> &keys,
          std::uint8_t const scaleFactor);
 
-  inline bool isOpen() const { return m_win.isOpen(); }
+  inline bool isOpen() const override {
+    return !m_created || m_win.isOpen();
+  }
 
   Screen(Screen const &) = delete;
   Screen &operator=(Screen const &) = delete;
   Screen(Screen &&) = delete;
   Screen &operator=(Screen &&) = delete;
 
-  void gpuExec();
-  void getInputs();
+  void gpuExec() override;
+  void getInputs() override;
+
+  void beep() override;
+  void setTelemetry(Telemetry &telemetry) override;
 
-  void beep();
+  // CHIP-8 key bound to a keyboard key, -1 when none
+  static int keyOf(sf::Keyboard::Key const key);
 
 private:
   std::uint32_t m_width;
   std::uint32_t m_height;
+  std::uint8_t m_scale;
+  bool m_created;
+  std::chrono::steady_clock::time_point m_windowDeadline;
+  std::uint32_t m_polls; // The clock is only read every few hundred polls
   sf::RenderWindow m_win;
   sf::Texture m_texture;
   sf::Sprite m_sprite;
   std::unique_ptr<sf::Uint8[]> m_pix;
   std::array<std::uint8_t, 0x800> const &m_gfx;
   std::array<bool, 16> &m_keys;
-  sf::SoundBuffer m_soundBuff;
-  sf::Sound m_beep;
+  // Constructing them opens the audio device, the loading thread does it
+  std::unique_ptr<sf::SoundBuffer> m_soundBuff;
+  std::unique_ptr<sf::Sound> m_beep;
+  std::future<void> m_audio; // Joined before the sound is destroyed
+  bool m_muted;
+
+  // Telemetry overlay, toggled with F1
+  Telemetry *m_telemetry;
+  bool m_overlay;
+  std::uint64_t m_titleSample;
 
+  void create();
   void loadBeep();
+  void drawOverlay();
 };
 } // namespace c8emu
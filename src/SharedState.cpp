@@ -0,0 +1,84 @@
+#include "SharedState.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+namespace c8emu {
+
+// Allocating space for constexpr symbols
+constexpr std::uint32_t SharedState::magic;
+constexpr std::uint32_t SharedState::version;
+constexpr std::uint32_t SharedState::keyOverride;
+
+SharedState::SharedState(std::string name)
+    : m_name(std::move(name)), m_fd(-1), m_layout(nullptr),
+      m_overridden(false) {
+  if (m_name.empty() || m_name[0] != '/') {
+    m_name.insert(0, 1, '/');
+  }
+
+  // Never attach to (and later unlink) the segment of another instance
+  m_fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (m_fd < 0) {
+    throw std::runtime_error(errno == EEXIST
+                                 ? "Shared memory already exists: " + m_name
+                                 : "Cannot open shared memory: " + m_name);
+  }
+  if (ftruncate(m_fd, sizeof(Layout)) != 0) {
+    close(m_fd);
+    shm_unlink(m_name.c_str());
+    throw std::runtime_error("Cannot resize shared memory: " + m_name);
+  }
+  void *const addr = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE,
+                          MAP_SHARED, m_fd, 0);
+  if (addr == MAP_FAILED) {
+    close(m_fd);
+    shm_unlink(m_name.c_str());
+    throw std::runtime_error("Cannot map shared memory: " + m_name);
+  }
+
+  m_layout = new (addr) Layout();
+  m_layout->magic = magic;
+  m_layout->version = version;
+}
+
+SharedState::~SharedState() {
+  munmap(m_layout, sizeof(Layout));
+  close(m_fd);
+  // Readers which still have it mapped keep their mapping
+  shm_unlink(m_name.c_str());
+}
+
+void SharedState::publish(GPU const &gpu, CPU::State const &state,
+                          std::array<bool, 16> const &keys) {
+  Layout &out = *m_layout;
+  std::uint32_t const generation =
+      out.generation.load(std::memory_order_relaxed);
+
+  out.generation.store(generation + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  std::uint16_t mask = 0;
+  for (std::size_t k = 0; k < keys.size(); ++k) {
+    mask = static_cast<std::uint16_t>(mask | (keys[k] ? 1 << k : 0));
+  }
+  ++out.frame;
+  out.framebuffer = gpu.data;
+  out.registers = state.registers;
+  out.stack = state.stack;
+  out.I = state.I;
+  out.pc = state.pc;
+  out.sp = state.sp;
+  out.opcode = state.opcode;
+  out.keys = mask;
+  out.delayTimer = state.delayTimer;
+  out.soundTimer = state.soundTimer;
+  out.status = static_cast<byte>(state.status);
+
+  out.generation.store(generation + 2, std::memory_order_release);
+}
+} // namespace c8emu
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CPU.hpp"
+#include "GPU.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace c8emu {
+// Publishes the framebuffer, registers and keypad of a running game in a
+// POSIX shared memory segment, for tools reading it without any copy on our
+// side. The emulator never waits for readers: updates are guarded by a
+// seqlock, readers retry when they raced with one.
+//
+// Reading a consistent snapshot:
+//   do {
+//     g = generation (acquire); if g is odd, retry
+//     copy the fields
+//     acquire fence
+//   } while (generation != g);
+//
+// Readers take over the keypad by storing keyMask | keyOverride in keysIn,
+// and give it back by storing 0. The segment must not exist yet, a stale one
+// left by a crash has to be removed (/dev/shm/name on Linux).
+class SharedState {
+  using byte = std::uint8_t;
+
+public:
+  constexpr static std::uint32_t magic = 0x48533843; // "C8SH"
+  constexpr static std::uint32_t version = 1;
+  constexpr static std::uint32_t keyOverride = 1 << 16;
+
+  // Segment layout, fixed size and offsets
+  struct Layout {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::atomic<std::uint32_t> generation; // Odd while being written
+    std::atomic<std::uint32_t> keysIn;     // Written by readers
+    std::uint64_t frame;                   // Frames published so far
+    std::array<byte, 0x800> framebuffer;   // 64x32, one byte per pixel
+    std::array<byte, 16> registers;
+    std::array<std::uint16_t, 16> stack;
+    std::uint16_t I;
+    std::uint16_t pc;
+    std::uint16_t sp;
+    std::uint16_t opcode;
+    std::uint16_t keys; // Bit i set when key i is pressed
+    byte delayTimer;
+    byte soundTimer;
+    byte status; // CPU::Status
+  };
+
+  // The name gets a leading '/' when missing
+  explicit SharedState(std::string name);
+  ~SharedState();
+
+  SharedState(SharedState const &) = delete;
+  SharedState &operator=(SharedState const &) = delete;
+  SharedState(SharedState &&) = delete;
+  SharedState &operator=(SharedState &&) = delete;
+
+  // Writes a new frame
+  void publish(GPU const &gpu, CPU::State const &state,
+               std::array<bool, 16> const &keys);
+
+  // Applies the readers' keypad while they hold it, called after every input
+  // poll. Keys they held are released when they give it back.
+  inline void applyKeys(std::array<bool, 16> &keys) {
+    std::uint32_t const in = m_layout->keysIn.load(std::memory_order_acquire);
+    if ((in & keyOverride) != 0) {
+      for (std::size_t k = 0; k < keys.size(); ++k) {
+        keys[k] = ((in >> k) & 1) != 0;
+      }
+      m_overridden = true;
+    } else if (m_overridden) {
+      keys.fill(false);
+      m_overridden = false;
+    }
+  }
+
+private:
+  std::string m_name;
+  int m_fd;
+  Layout *m_layout;
+  bool m_overridden;
+};
+
+// Readers outside of C++ rely on this layout
+static_assert(ATOMIC_INT_LOCK_FREE == 2 &&
+                  sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "Shared counters must be plain lock-free words");
+static_assert(std::is_standard_layout<SharedState::Layout>::value,
+              "Shared layout must be standard layout");
+static_assert(offsetof(SharedState::Layout, generation) == 8 &&
+                  offsetof(SharedState::Layout, keysIn) == 12 &&
+                  offsetof(SharedState::Layout, frame) == 16 &&
+                  offsetof(SharedState::Layout, framebuffer) == 24 &&
+                  offsetof(SharedState::Layout, registers) == 2072 &&
+                  offsetof(SharedState::Layout, stack) == 2088 &&
+                  offsetof(SharedState::Layout, I) == 2120 &&
+                  offsetof(SharedState::Layout, keys) == 2128 &&
+                  offsetof(SharedState::Layout, status) == 2132 &&
+                  sizeof(SharedState::Layout) == 2136,
+              "Shared layout changed, bump SharedState::version");
+} // namespace c8emu
@@ -0,0 +1,110 @@
+#include "Telemetry.hpp"
+#include <cstdio>
+
+namespace c8emu {
+
+// Allocating space for constexpr symbols
+constexpr std::size_t Telemetry::phaseCount;
+constexpr std::uint32_t Telemetry::samplePeriod;
+constexpr std::size_t Telemetry::bucketCount;
+constexpr std::chrono::microseconds Telemetry::bucketWidth;
+
+Telemetry::Telemetry()
+    : m_iteration(0), m_periodStart(clock::now()), m_lastPresent(),
+      m_instructions(0), m_frames(0), m_presented(0), m_phases(),
+      m_histogram(), m_last(), m_samples(0) {
+  for (std::atomic<std::uint64_t> &phase : m_phases) {
+    phase.store(0, std::memory_order_relaxed);
+  }
+  for (std::atomic<std::uint32_t> &bucket : m_histogram) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Telemetry::presented(clock::time_point const now) {
+  if (m_lastPresent != clock::time_point()) {
+    std::size_t const bucket =
+        static_cast<std::size_t>((now - m_lastPresent) / bucketWidth);
+    m_histogram[bucket < bucketCount ? bucket : bucketCount - 1].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+  m_lastPresent = now;
+  m_presented.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool Telemetry::update(clock::time_point const now, CPU::Stats const &stats) {
+  std::chrono::duration<double> const elapsed = now - m_periodStart;
+  if (elapsed < std::chrono::seconds(1)) {
+    return false;
+  }
+
+  Sample sample;
+  std::uint64_t const instructions = stats.executed + stats.elided;
+  sample.seconds = elapsed.count();
+  sample.instructions = instructions - m_instructions;
+  sample.emulatedFrames = stats.frames - m_frames;
+  sample.presentedFrames = m_presented.exchange(0, std::memory_order_relaxed);
+
+  // Counted from the histogram: the first present of a period has a frame
+  // time only when one came before it
+  std::uint64_t frameTimes = 0;
+  for (std::atomic<std::uint32_t> const &bucket : m_histogram) {
+    frameTimes += bucket.load(std::memory_order_relaxed);
+  }
+  sample.frameP50 = percentile(frameTimes, 0.50);
+  sample.frameP99 = percentile(frameTimes, 0.99);
+  for (std::atomic<std::uint32_t> &bucket : m_histogram) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+
+  for (std::size_t p = 0; p < phaseCount; ++p) {
+    std::chrono::duration<double> const spent =
+        clock::duration(static_cast<clock::rep>(
+            m_phases[p].exchange(0, std::memory_order_relaxed)));
+    sample.phases[p] = 100. * spent.count() / elapsed.count();
+  }
+
+  m_instructions = instructions;
+  m_frames = stats.frames;
+  m_periodStart = now;
+  m_last = sample;
+  ++m_samples;
+  return true;
+}
+
+// Upper bound of the bucket holding the given rank, in ms
+double Telemetry::percentile(std::uint64_t const total,
+                             double const rank) const {
+  if (total == 0) {
+    return 0;
+  }
+
+  std::uint64_t const target =
+      static_cast<std::uint64_t>(rank * static_cast<double>(total));
+  std::uint64_t seen = 0;
+  for (std::size_t b = 0; b < bucketCount; ++b) {
+    seen += m_histogram[b].load(std::memory_order_relaxed);
+    if (seen > target) {
+      return static_cast<double>((b + 1) * bucketWidth.count()) / 1000.;
+    }
+  }
+  return static_cast<double>(bucketCount * bucketWidth.count()) / 1000.;
+}
+
+std::size_t Telemetry::json(char *buf, std::size_t const size) const {
+  int const len = std::snprintf(
+      buf, size,
+      "{\"seconds\":%.3f,\"instructions\":%llu,\"emulated_frames\":%llu,"
+      "\"presented_frames\":%llu,\"frame_p50_ms\":%.2f,\"frame_p99_ms\":%.2f,"
+      "\"execute_pct\":%.1f,\"gpu_exec_pct\":%.1f,\"get_inputs_pct\":%.1f}\n",
+      m_last.seconds, static_cast<unsigned long long>(m_last.instructions),
+      static_cast<unsigned long long>(m_last.emulatedFrames),
+      static_cast<unsigned long long>(m_last.presentedFrames), m_last.frameP50,
+      m_last.frameP99, m_last.phases[0], m_last.phases[1], m_last.phases[2]);
+  if (len < 0 || size == 0) {
+    return 0;
+  }
+  return static_cast<std::size_t>(len) < size ? static_cast<std::size_t>(len)
+                                              : size - 1;
+}
+} // namespace c8emu
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CPU.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace c8emu {
+// Per second performance counters of a running game. Nothing updated from the
+// emulation loop locks or allocates. Only the frame and phase counters are
+// atomic: the samples (last(), samples()) are plain data, to be read from the
+// thread calling update().
+class Telemetry {
+public:
+  using clock = std::chrono::steady_clock;
+
+  enum class Phase : std::uint8_t { Execute, GpuExec, GetInputs };
+  constexpr static std::size_t phaseCount = 3;
+
+  // The execute() and getInputs() phases are too short to be timed every
+  // iteration, only one iteration out of samplePeriod is
+  constexpr static std::uint32_t samplePeriod = 256;
+
+  // Host frame times are bucketed by 0.25ms, the last bucket takes the rest
+  constexpr static std::size_t bucketCount = 256;
+  constexpr static std::chrono::microseconds bucketWidth{250};
+
+  struct Sample {
+    double seconds;                        // Length of the period
+    std::uint64_t instructions;            // Executed or elided
+    std::uint64_t emulatedFrames;          // Framebuffer updates by the game
+    std::uint64_t presentedFrames;         // Frames shown by the frontend
+    double frameP50;                       // Host frame time, in ms
+    double frameP99;                       // Host frame time, in ms
+    std::array<double, phaseCount> phases; // Share of host time, in %
+  };
+
+  Telemetry();
+
+  Telemetry(Telemetry const &) = delete;
+  Telemetry &operator=(Telemetry const &) = delete;
+  Telemetry(Telemetry &&) = delete;
+  Telemetry &operator=(Telemetry &&) = delete;
+
+  // True once every samplePeriod calls
+  inline bool sampling() { return (++m_iteration & (samplePeriod - 1)) == 0; }
+  inline void addTime(Phase const phase, clock::duration const time) {
+    m_phases[static_cast<std::size_t>(phase)].fetch_add(
+        static_cast<std::uint64_t>(time.count()), std::memory_order_relaxed);
+  }
+  void presented(clock::time_point const now);
+
+  // Closes the current period when a second has passed since the last one,
+  // the CPU counters are read as running totals. Returns true when it did.
+  bool update(clock::time_point const now, CPU::Stats const &stats);
+
+  inline Sample const &last() const { return m_last; }
+  inline std::uint64_t samples() const { return m_samples; }
+  // Formats the last sample as one line of JSON, returns its length
+  std::size_t json(char *buf, std::size_t const size) const;
+
+private:
+  std::uint32_t m_iteration;
+
+  // Current period
+  clock::time_point m_periodStart;
+  clock::time_point m_lastPresent;
+  std::uint64_t m_instructions;
+  std::uint64_t m_frames;
+  std::atomic<std::uint64_t> m_presented;
+  std::array<std::atomic<std::uint64_t>, phaseCount> m_phases;
+  std::array<std::atomic<std::uint32_t>, bucketCount> m_histogram;
+
+  Sample m_last;
+  std::uint64_t m_samples;
+
+  double percentile(std::uint64_t const total, double const rank) const;
+};
+} // namespace c8emu
@@ -0,0 +1,195 @@
+#include "Terminal.hpp"
+#include <cctype>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace c8emu {
+namespace {
+// Cell glyphs indexed by (bottom pixel << 1) | top pixel, in UTF-8
+constexpr std::array<char const *, 4> glyphs = {{
+    " ",            // Empty
+    "\xE2\x96\x80", // Upper half block
+    "\xE2\x96\x84", // Lower half block
+    "\xE2\x96\x88"  // Full block
+}};
+
+// Keyboard layout of Screen, indexed by CHIP-8 key
+constexpr std::array<char, 16> layout = {{'x', '1', '2', '3', 'q', 'w', 'e',
+                                          'a', 's', 'd', 'z', 'c', '4', 'r',
+                                          'f', 'v'}};
+
+// Unchanged cells are written over rather than jumped over when the gap is
+// this short, a cursor move takes at least 6 bytes
+constexpr std::size_t maxGap = 2;
+
+void appendNumber(std::string &out, std::size_t value) {
+  char digits[20];
+  std::size_t len = 0;
+
+  do {
+    digits[len++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (len != 0) {
+    out += digits[--len];
+  }
+}
+} // namespace
+
+// Allocating space for constexpr symbols
+constexpr std::size_t Terminal::width;
+constexpr std::size_t Terminal::height;
+constexpr std::uint32_t Terminal::pollPeriod;
+constexpr std::chrono::milliseconds Terminal::frameInterval;
+constexpr std::chrono::milliseconds Terminal::keyHold;
+
+Terminal::Terminal(std::array<std::uint8_t, 0x800> const &gfx,
+                   std::array<bool, 16> &keys)
+    : m_gfx(gfx), m_keys(keys), m_releaseAt(), m_saved(), m_open(true),
+      m_cells(), m_out(), m_lastFrame(), m_calls(0), m_dirty(true),
+      m_bell(false), m_telemetry(nullptr) {
+  if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &m_saved) != 0) {
+    throw std::runtime_error("stdin is not a terminal");
+  }
+
+  // Raw, non-blocking input: no echo, no line buffering, ^C is read as a key
+  struct termios raw = m_saved;
+  raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | ISIG);
+  raw.c_iflag &= ~static_cast<tcflag_t>(IXON | ICRNL);
+  raw.c_cc[VMIN] = 0;
+  raw.c_cc[VTIME] = 0;
+  if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0) {
+    throw std::runtime_error("Cannot set terminal in raw mode");
+  }
+
+  // Nothing matches these, the first frame is written whole
+  m_cells.fill(0xFF);
+  m_out.reserve(width * (height / 2) * 3 + 1024);
+
+  // Alternate screen, hidden cursor, cleared
+  m_out += "\x1B[?1049h\x1B[?25l\x1B[2J";
+  flush();
+}
+
+Terminal::~Terminal() {
+  m_out += "\x1B[?25h\x1B[?1049l";
+  flush();
+  tcsetattr(STDIN_FILENO, TCSAFLUSH, &m_saved);
+}
+
+void Terminal::gpuExec() { m_dirty = true; }
+
+void Terminal::beep() { m_bell = true; }
+
+void Terminal::setTelemetry(Telemetry &telemetry) {
+  m_telemetry = &telemetry;
+}
+
+void Terminal::getInputs() {
+  if (++m_calls < pollPeriod) {
+    return;
+  }
+  m_calls = 0;
+
+  clock::time_point const now = clock::now();
+  readKeys(now);
+
+  // Frames are rate limited, the latest framebuffer is shown at most every
+  // frameInterval
+  if ((m_dirty || m_bell) && now - m_lastFrame >= frameInterval) {
+    present();
+    if (m_dirty && m_telemetry != nullptr) {
+      m_telemetry->presented(clock::now());
+    }
+    m_lastFrame = now;
+    m_dirty = false;
+  }
+}
+
+void Terminal::readKeys(clock::time_point const now) {
+  char buf[64];
+  ssize_t const len = read(STDIN_FILENO, buf, sizeof(buf));
+
+  for (ssize_t i = 0; i < len; ++i) {
+    char const c =
+        static_cast<char>(std::tolower(static_cast<unsigned char>(buf[i])));
+
+    // ^C, or Escape alone (escape sequences come in one read)
+    if (c == '\x03' || (c == '\x1B' && len == 1)) {
+      m_open = false;
+    }
+    for (std::size_t k = 0; k < layout.size(); ++k) {
+      if (layout[k] == c) {
+        m_keys[k] = true;
+        m_releaseAt[k] = now + keyHold;
+      }
+    }
+  }
+
+  // Only keys pressed here are released, others may be driven from outside
+  for (std::size_t k = 0; k < m_keys.size(); ++k) {
+    if (m_releaseAt[k] != clock::time_point() && now >= m_releaseAt[k]) {
+      m_keys[k] = false;
+      m_releaseAt[k] = clock::time_point();
+    }
+  }
+}
+
+void Terminal::present() {
+  // Cursor position, height means unknown
+  std::size_t curRow = height;
+  std::size_t curCol = 0;
+
+  for (std::size_t row = 0; row < height / 2; ++row) {
+    for (std::size_t col = 0; col < width; ++col) {
+      std::size_t const top = (row * 2) * width + col;
+      std::uint8_t const cell = static_cast<std::uint8_t>(
+          (m_gfx[top] != 0 ? 1 : 0) | (m_gfx[top + width] != 0 ? 2 : 0));
+      std::uint8_t &shown = m_cells[row * width + col];
+
+      if (cell == shown) {
+        continue;
+      }
+      if (row == curRow && col - curCol <= maxGap) {
+        for (std::size_t c = curCol; c < col; ++c) {
+          m_out += glyphs[m_cells[row * width + c]];
+        }
+      } else {
+        m_out += "\x1B[";
+        appendNumber(m_out, row + 1);
+        m_out += ';';
+        appendNumber(m_out, col + 1);
+        m_out += 'H';
+      }
+      m_out += glyphs[cell];
+      shown = cell;
+      curRow = row;
+      curCol = col + 1;
+    }
+  }
+
+  if (m_bell) {
+    m_out += '\a';
+    m_bell = false;
+  }
+  flush();
+}
+
+void Terminal::flush() {
+  std::size_t done = 0;
+
+  while (done < m_out.size()) {
+    ssize_t const len =
+        write(STDOUT_FILENO, m_out.data() + done, m_out.size() - done);
+    if (len < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    done += static_cast<std::size_t>(len);
+  }
+  m_out.clear();
+}
+} // namespace c8emu
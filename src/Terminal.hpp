@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Frontend.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <termios.h>
+
+namespace c8emu {
+// Text frontend for terminals without a display (e.g. over SSH). Two CHIP-8
+// rows fit in one terminal row thanks to the Unicode half blocks, only the
+// cells which changed since the last frame are written, with one write() per
+// frame. Keys are read from stdin in raw mode; terminals don't report key
+// releases, so a key stays pressed until it hasn't repeated for keyHold.
+class Terminal : public Frontend {
+  using clock = std::chrono::steady_clock;
+
+public:
+  constexpr static std::size_t width = 64;
+  constexpr static std::size_t height = 32;
+
+  Terminal(std::array<std::uint8_t, 0x800> const &gfx,
+           std::array<bool, 16> &keys);
+  ~Terminal() override;
+
+  Terminal(Terminal const &) = delete;
+  Terminal &operator=(Terminal const &) = delete;
+  Terminal(Terminal &&) = delete;
+  Terminal &operator=(Terminal &&) = delete;
+
+  inline bool isOpen() const override { return m_open; }
+  void gpuExec() override;
+  void getInputs() override;
+  void beep() override;
+  void setTelemetry(Telemetry &telemetry) override;
+
+private:
+  // getInputs() is called once per instruction, the terminal is only looked
+  // at every pollPeriod calls
+  constexpr static std::uint32_t pollPeriod = 1024;
+  constexpr static std::chrono::milliseconds frameInterval{16};
+  constexpr static std::chrono::milliseconds keyHold{150};
+
+  std::array<std::uint8_t, 0x800> const &m_gfx;
+  std::array<bool, 16> &m_keys;
+  std::array<clock::time_point, 16> m_releaseAt;
+  struct termios m_saved;
+  bool m_open;
+
+  // Output
+  std::array<std::uint8_t, width *(height / 2)> m_cells; // As last written
+  std::string m_out;
+  clock::time_point m_lastFrame;
+  std::uint32_t m_calls;
+  bool m_dirty;
+  bool m_bell;
+  Telemetry *m_telemetry;
+
+  void present();
+  void readKeys(clock::time_point const now);
+  void flush();
+};
+} // namespace c8emu
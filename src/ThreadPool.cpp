@@ -0,0 +1,91 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace c8emu {
+ThreadPool::ThreadPool(std::size_t threads)
+    : m_workers(), m_mutex(), m_start(), m_finish(), m_job(nullptr),
+      m_count(0), m_grain(1), m_next(0), m_generation(0), m_busy(0),
+      m_stop(false) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (std::size_t i = 1; i < threads; ++i) {
+    m_workers.emplace_back([this]() { this->workerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all();
+  for (std::thread &worker : m_workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::parallelFor(std::size_t const count,
+                             std::function<void(std::size_t)> const &job) {
+  if (m_workers.empty() || count <= 1) {
+    for (std::size_t i = 0; i < count; ++i) {
+      job(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = &job;
+    m_count = count;
+    // A few chunks per thread keeps them balanced without hammering m_next
+    m_grain = std::max<std::size_t>(1, count / (size() * 4));
+    m_next.store(0, std::memory_order_relaxed);
+    m_busy = m_workers.size();
+    ++m_generation;
+  }
+  m_start.notify_all();
+  drain();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_finish.wait(lock, [this]() { return m_busy == 0; });
+  m_job = nullptr;
+}
+
+void ThreadPool::drain() {
+  for (;;) {
+    std::size_t const begin =
+        m_next.fetch_add(m_grain, std::memory_order_relaxed);
+    if (begin >= m_count) {
+      return;
+    }
+    std::size_t const end = std::min(begin + m_grain, m_count);
+    for (std::size_t i = begin; i < end; ++i) {
+      (*m_job)(i);
+    }
+  }
+}
+
+void ThreadPool::workerLoop() {
+  std::uint64_t seen = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start.wait(lock,
+                   [this, seen]() { return m_stop || m_generation != seen; });
+      if (m_stop) {
+        return;
+      }
+      seen = m_generation;
+    }
+
+    drain();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_busy == 0) {
+      m_finish.notify_one();
+    }
+  }
+}
+} // namespace c8emu
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace c8emu {
+// Fixed set of workers running parallel loops. The calling thread takes part
+// in the work, so a pool of size 1 runs everything inline.
+class ThreadPool {
+public:
+  // 0 uses one thread per hardware thread
+  explicit ThreadPool(std::size_t threads);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+
+  // Calls job(i) for every i < count and waits for all of them
+  void parallelFor(std::size_t const count,
+                   std::function<void(std::size_t)> const &job);
+
+  inline std::size_t size() const { return m_workers.size() + 1; }
+
+private:
+  std::vector<std::thread> m_workers;
+  std::mutex m_mutex;
+  std::condition_variable m_start;
+  std::condition_variable m_finish;
+
+  // Current loop
+  std::function<void(std::size_t)> const *m_job;
+  std::size_t m_count;
+  std::size_t m_grain;
+  std::atomic<std::size_t> m_next;
+  std::uint64_t m_generation;
+  std::size_t m_busy;
+  bool m_stop;
+
+  void workerLoop();
+  void drain();
+};
+} // namespace c8emu
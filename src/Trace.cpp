@@ -0,0 +1,160 @@
+#include "Trace.hpp"
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace c8emu {
+
+// Allocating space for constexpr symbols
+constexpr std::size_t TraceWriter::blockSize;
+constexpr std::size_t TraceWriter::blockCount;
+constexpr std::size_t TraceWriter::maxRecordSize;
+
+namespace {
+constexpr std::array<char, 4> const traceMagic = {{'C', '8', 'T', 'R'}};
+constexpr std::uint32_t const traceVersion = 1;
+} // namespace
+
+TraceWriter::TraceWriter(std::string const &file)
+    : m_file(std::fopen(file.c_str(), "wb")), m_block(blockSize), m_pos(0),
+      m_mutex(), m_cond(), m_full(), m_free(), m_done(false),
+      m_failed(false), m_thread() {
+  if (m_file == nullptr) {
+    throw std::runtime_error("Cannot open trace file: " + file);
+  }
+
+  // Header
+  std::memcpy(m_block.data(), traceMagic.data(), traceMagic.size());
+  for (std::size_t i = 0; i < 4; ++i) {
+    m_block[4 + i] = static_cast<byte>(traceVersion >> (i * 8));
+  }
+  m_pos = 8;
+
+  for (std::size_t i = 1; i < blockCount; ++i) {
+    m_free.emplace_back(blockSize);
+  }
+  m_thread = std::thread([this]() { this->writerLoop(); });
+}
+
+TraceWriter::~TraceWriter() {
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_done = true;
+  }
+  m_cond.notify_all();
+  m_thread.join();
+  if (m_failed) {
+    std::cerr << "Trace: write error, trace is truncated" << std::endl;
+  }
+  std::fclose(m_file);
+}
+
+// Hand the current block to the writer thread and grab an empty one. We only
+// block when every buffer is still waiting to be written.
+void TraceWriter::flush() {
+  m_block.resize(m_pos);
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_full.push_back(std::move(m_block));
+    m_cond.notify_all();
+    m_cond.wait(lock, [this]() { return !m_free.empty(); });
+    m_block = std::move(m_free.back());
+    m_free.pop_back();
+  }
+  m_block.resize(blockSize);
+  m_pos = 0;
+}
+
+void TraceWriter::writerLoop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  for (;;) {
+    m_cond.wait(lock, [this]() { return m_done || !m_full.empty(); });
+    if (m_full.empty()) {
+      return;
+    }
+    std::vector<byte> block = std::move(m_full.front());
+    m_full.pop_front();
+
+    // Write without holding the lock, the emulation thread keeps going
+    lock.unlock();
+    if (!m_failed &&
+        std::fwrite(block.data(), 1, block.size(), m_file) != block.size()) {
+      m_failed = true;
+    }
+    lock.lock();
+
+    m_free.push_back(std::move(block));
+    m_cond.notify_all();
+  }
+}
+
+TraceReader::TraceReader(std::string const &file)
+    : m_file(std::fopen(file.c_str(), "rb")), m_buff(1 << 20), m_pos(0),
+      m_len(0) {
+  if (m_file == nullptr) {
+    throw std::runtime_error("Cannot open trace file: " + file);
+  }
+  if (!fill(8) ||
+      std::memcmp(m_buff.data(), traceMagic.data(), traceMagic.size()) != 0) {
+    std::fclose(m_file);
+    throw std::runtime_error("Invalid trace file: " + file);
+  }
+
+  std::uint32_t version = 0;
+  for (std::size_t i = 0; i < 4; ++i) {
+    version |= static_cast<std::uint32_t>(m_buff[4 + i]) << (i * 8);
+  }
+  if (version != traceVersion) {
+    std::fclose(m_file);
+    throw std::runtime_error("Unsupported trace version: " + file);
+  }
+  m_pos = 8;
+}
+
+TraceReader::~TraceReader() { std::fclose(m_file); }
+
+// Make sure at least `needed` bytes are buffered
+bool TraceReader::fill(std::size_t const needed) {
+  if (m_len - m_pos >= needed) {
+    return true;
+  }
+  std::memmove(m_buff.data(), m_buff.data() + m_pos, m_len - m_pos);
+  m_len -= m_pos;
+  m_pos = 0;
+  m_len += std::fread(m_buff.data() + m_len, 1, m_buff.size() - m_len, m_file);
+  return m_len >= needed;
+}
+
+bool TraceReader::next(TraceRecord &rec) {
+  if (!fill(8)) {
+    return false;
+  }
+
+  byte const *in = m_buff.data() + m_pos;
+  rec.pc = static_cast<std::uint16_t>(in[0] | (in[1] << 8));
+  rec.opcode = static_cast<std::uint16_t>(in[2] | (in[3] << 8));
+  rec.I = static_cast<std::uint16_t>(in[4] | (in[5] << 8));
+  rec.mask = static_cast<std::uint16_t>(in[6] | (in[7] << 8));
+
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < 16; ++i) {
+    count += (rec.mask >> i) & 1;
+  }
+  if (!fill(8 + count)) {
+    throw std::runtime_error("Truncated trace record");
+  }
+  in = m_buff.data() + m_pos + 8;
+
+  rec.values.fill(0);
+  for (std::size_t i = 0; i < 16; ++i) {
+    if ((rec.mask >> i) & 1) {
+      rec.values[i] = *in++;
+    }
+  }
+  m_pos += 8 + count;
+  return true;
+}
+
+} // namespace c8emu
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace c8emu {
+// Execution trace file layout:
+//   header: "C8TR" followed by a little-endian u32 version
+//   records: u16 pc, u16 opcode, u16 I, u16 mask of the registers written by
+//            the instruction, then one byte per bit set in the mask (V0 first)
+// All integers are little-endian.
+struct TraceRecord {
+  std::uint16_t pc;
+  std::uint16_t opcode;
+  std::uint16_t I;
+  std::uint16_t mask;
+  std::array<std::uint8_t, 16> values;
+};
+
+inline bool operator==(TraceRecord const &a, TraceRecord const &b) {
+  return a.pc == b.pc && a.opcode == b.opcode && a.I == b.I &&
+         a.mask == b.mask && a.values == b.values;
+}
+
+inline bool operator!=(TraceRecord const &a, TraceRecord const &b) {
+  return !(a == b);
+}
+
+class TraceWriter {
+  using byte = std::uint8_t;
+
+public:
+  explicit TraceWriter(std::string const &file);
+  ~TraceWriter();
+
+  TraceWriter(TraceWriter const &) = delete;
+  TraceWriter &operator=(TraceWriter const &) = delete;
+  TraceWriter(TraceWriter &&) = delete;
+  TraceWriter &operator=(TraceWriter &&) = delete;
+
+  inline void record(std::uint16_t const pc, std::uint16_t const opcode,
+                     std::uint16_t const I,
+                     std::array<byte, 16> const &before,
+                     std::array<byte, 16> const &after) {
+    if (m_pos + maxRecordSize > m_block.size()) {
+      flush();
+    }
+    byte *out = m_block.data() + m_pos;
+    std::uint16_t mask = 0;
+    std::size_t len = 8;
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      if (before[i] != after[i]) {
+        mask = static_cast<std::uint16_t>(mask | (1 << i));
+        out[len++] = after[i];
+      }
+    }
+    write16(out, pc);
+    write16(out + 2, opcode);
+    write16(out + 4, I);
+    write16(out + 6, mask);
+    m_pos += len;
+  }
+
+private:
+  constexpr static std::size_t blockSize = 1 << 20;
+  constexpr static std::size_t blockCount = 4;
+  constexpr static std::size_t maxRecordSize = 8 + 16;
+
+  std::FILE *m_file;
+  std::vector<byte> m_block;
+  std::size_t m_pos;
+
+  // Blocks handed over to the writer thread, and blocks ready to be reused
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::deque<std::vector<byte>> m_full;
+  std::vector<std::vector<byte>> m_free;
+  bool m_done;
+  bool m_failed;
+  std::thread m_thread;
+
+  void flush();
+  void writerLoop();
+
+  static inline void write16(byte *out, std::uint16_t const val) {
+    out[0] = static_cast<byte>(val & 0xFF);
+    out[1] = static_cast<byte>(val >> 8);
+  }
+};
+
+class TraceReader {
+  using byte = std::uint8_t;
+
+public:
+  explicit TraceReader(std::string const &file);
+  ~TraceReader();
+
+  TraceReader(TraceReader const &) = delete;
+  TraceReader &operator=(TraceReader const &) = delete;
+  TraceReader(TraceReader &&) = delete;
+  TraceReader &operator=(TraceReader &&) = delete;
+
+  // Returns false once the end of the trace is reached
+  bool next(TraceRecord &rec);
+
+private:
+  std::FILE *m_file;
+  std::vector<byte> m_buff;
+  std::size_t m_pos;
+  std::size_t m_len;
+
+  bool fill(std::size_t const needed);
+};
+} // namespace c8emu
@@ -0,0 +1,75 @@
+#include "Trace.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+using c8emu::TraceRecord;
+
+void printRecord(char const *name, TraceRecord const &rec,
+                 std::array<std::uint8_t, 16> const &registers) {
+  std::cout << std::hex << std::uppercase << std::setfill('0') << name
+            << ": PC=" << std::setw(3) << rec.pc << " opcode=" << std::setw(4)
+            << rec.opcode << " I=" << std::setw(3) << rec.I << std::endl
+            << "  ";
+  for (std::size_t i = 0; i < 16; ++i) {
+    std::cout << 'V' << i << '=' << std::setw(2)
+              << static_cast<unsigned>(registers[i])
+              << (((rec.mask >> i) & 1) ? "* " : "  ");
+  }
+  std::cout << std::dec << std::endl;
+}
+
+void apply(TraceRecord const &rec, std::array<std::uint8_t, 16> &registers) {
+  for (std::size_t i = 0; i < 16; ++i) {
+    if ((rec.mask >> i) & 1) {
+      registers[i] = rec.values[i];
+    }
+  }
+}
+} // namespace
+
+int main(int ac, char *av[]) {
+  if (ac != 3) {
+    std::cout << "Usage: " << *av << " trace_a trace_b" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    c8emu::TraceReader a(av[1]);
+    c8emu::TraceReader b(av[2]);
+    TraceRecord recA;
+    TraceRecord recB;
+    std::array<std::uint8_t, 16> regsA{{0}};
+    std::array<std::uint8_t, 16> regsB{{0}};
+
+    for (std::uint64_t count = 0;; ++count) {
+      bool const hasA = a.next(recA);
+      bool const hasB = b.next(recB);
+
+      if (!hasA && !hasB) {
+        std::cout << "Traces are identical (" << count << " instructions)"
+                  << std::endl;
+        return EXIT_SUCCESS;
+      }
+      if (!hasA || !hasB) {
+        std::cout << "Traces diverge at instruction " << count << ": "
+                  << (hasA ? av[2] : av[1]) << " ends here" << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      apply(recA, regsA);
+      apply(recB, regsB);
+      if (recA != recB) {
+        std::cout << "Traces diverge at instruction " << count << std::endl;
+        printRecord(av[1], recA, regsA);
+        printRecord(av[2], recB, regsB);
+        return EXIT_FAILURE;
+      }
+    }
+  } catch (std::exception const &e) {
+    std::cerr << e.what() << std::endl;
+  }
+  return EXIT_FAILURE;
+}
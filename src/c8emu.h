@@ -0,0 +1,60 @@
+#ifndef C8EMU_H_
+#define C8EMU_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* C interface to the vectorized environments, see Env.hpp */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum c8emu_hook_format {
+  C8EMU_HOOK_NONE = 0,
+  C8EMU_HOOK_BYTE = 1,
+  C8EMU_HOOK_BCD = 2
+};
+
+typedef struct c8emu_env_config {
+  size_t cycles_per_frame;
+  size_t frame_skip;
+  int reward_format; /* c8emu_hook_format */
+  uint16_t reward_address;
+  int done_format; /* c8emu_hook_format */
+  uint16_t done_address;
+  uint32_t done_value;
+  size_t threads; /* 0 uses one thread per hardware thread */
+} c8emu_env_config;
+
+typedef struct c8emu_env c8emu_env;
+
+/* Fills config with the defaults */
+void c8emu_env_config_init(c8emu_env_config *config);
+
+/* Returns NULL on failure, c8emu_last_error() tells why */
+c8emu_env *c8emu_env_create(char const *game, size_t count,
+                            c8emu_env_config const *config);
+c8emu_env *c8emu_env_create_from_memory(uint8_t const *data, size_t len,
+                                        size_t count,
+                                        c8emu_env_config const *config);
+void c8emu_env_destroy(c8emu_env *env);
+char const *c8emu_last_error(void);
+
+size_t c8emu_env_size(c8emu_env const *env);
+void c8emu_env_reset(c8emu_env *env, uint32_t seed);
+void c8emu_env_reset_one(c8emu_env *env, size_t index, uint32_t seed);
+/* actions[i] is the mask of the keys held by environment i */
+void c8emu_env_step(c8emu_env *env, uint16_t const *actions, size_t frames);
+
+/* Arrays of c8emu_env_size() elements, valid until the next call */
+float const *c8emu_env_rewards(c8emu_env const *env);
+uint8_t const *c8emu_env_dones(c8emu_env const *env);
+/* 64x32 bytes, valid for the lifetime of env */
+uint8_t const *c8emu_env_observation(c8emu_env const *env, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !C8EMU_H_ */
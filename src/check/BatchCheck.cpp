@@ -0,0 +1,78 @@
+#include "../Batch.hpp"
+#include "../Machine.hpp"
+#include "Check.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Lockstep batch differential: every lane of a Batch must end up like a
+// scalar Machine given the same program, seed and keys. Half of the scalar
+// machines skip idle loops, which the batch never does.
+namespace {
+using c8emu::Batch;
+using c8emu::Machine;
+using c8emu::check::sameState;
+
+constexpr std::size_t programCount = 3000;
+constexpr std::size_t cycles = 2000;
+constexpr std::uint32_t seed = 77;
+
+// Returns the number of lanes which differ from their scalar machine
+std::size_t check(std::vector<std::uint8_t> const &program,
+                  std::size_t const lanes, bool const keys) {
+  Batch batch(lanes);
+  std::unique_ptr<Machine[]> machines = std::make_unique<Machine[]>(lanes);
+
+  batch.reset(seed);
+  batch.load(program.data(), program.size());
+  for (std::size_t l = 0; l < lanes; ++l) {
+    Machine &machine = machines[l];
+    machine.reset(seed + static_cast<std::uint32_t>(l));
+    machine.cpu().setIdleSkip(l % 2 != 0);
+    machine.load(program.data(), program.size());
+    // A different key held in each lane makes the lanes diverge
+    if (keys) {
+      batch.keys(l)[l % 16] = true;
+      machine.keys()[l % 16] = true;
+    }
+  }
+
+  batch.run(cycles);
+  std::size_t failures = 0;
+  for (std::size_t l = 0; l < lanes; ++l) {
+    machines[l].run(cycles);
+    c8emu::GPU gpu;
+    batch.unpack(l, gpu);
+    if (!sameState(batch.state(l), machines[l].cpu().state()) ||
+        batch.memory(l) != machines[l].memory() ||
+        gpu.data != machines[l].gpu().data) {
+      ++failures;
+    }
+  }
+  return failures;
+}
+} // namespace
+
+int main() {
+  std::mt19937 rng(30);
+  std::size_t failures = 0;
+
+  for (std::size_t p = 0; p < programCount; ++p) {
+    std::vector<std::uint8_t> const program =
+        c8emu::check::randomProgram(rng, 64 + rng() % 512);
+    std::size_t const lanes = 1 + rng() % Batch::maxLanes;
+    std::size_t const differ = check(program, lanes, rng() % 2 == 0);
+    if (differ != 0) {
+      std::cout << "Program " << p << ": " << differ << " of " << lanes
+                << " lanes differ" << std::endl;
+    }
+    failures += differ;
+  }
+
+  std::cout << failures << " batch lane mismatches" << std::endl;
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,36 @@
+#include "Check.hpp"
+#include <array>
+
+namespace c8emu {
+namespace check {
+
+std::vector<std::uint8_t> randomProgram(std::mt19937 &rng,
+                                        std::size_t const len) {
+  constexpr std::array<std::uint8_t, 15> groups = {{0x00, 0x10, 0x20, 0x30,
+                                                    0x40, 0x50, 0x60, 0x70,
+                                                    0x80, 0x90, 0xA0, 0xC0,
+                                                    0xD0, 0xE0, 0xF0}};
+  std::vector<std::uint8_t> program(len);
+
+  for (std::uint8_t &b : program) {
+    b = static_cast<std::uint8_t>(rng());
+  }
+  for (std::size_t i = 0; i + 1 < len; i += 2) {
+    if (rng() % 2 == 0) {
+      continue;
+    }
+    std::uint8_t const group = groups[rng() % groups.size()];
+    program[i] = static_cast<std::uint8_t>(
+        group | (group == 0x10 || group == 0x20 ? 0x2 : program[i] & 0x0F));
+  }
+  return program;
+}
+
+bool sameState(CPU::State const &a, CPU::State const &b) {
+  return a.opcode == b.opcode && a.registers == b.registers && a.I == b.I &&
+         a.pc == b.pc && a.stack == b.stack && a.sp == b.sp &&
+         a.status == b.status && a.rand == b.rand &&
+         a.delayTimer == b.delayTimer && a.soundTimer == b.soundTimer;
+}
+} // namespace check
+} // namespace c8emu
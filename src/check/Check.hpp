@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../CPU.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace c8emu {
+namespace check {
+// Random program of len bytes. About one word out of two is drawn from the
+// opcode groups games use, with jumps and calls kept inside 0x200-0x2FF, so
+// runs get past their first few instructions.
+std::vector<std::uint8_t> randomProgram(std::mt19937 &rng,
+                                        std::size_t const len);
+
+// Whole CPU state equality, timers and rand state included
+bool sameState(CPU::State const &a, CPU::State const &b);
+} // namespace check
+} // namespace c8emu
@@ -0,0 +1,123 @@
+#include "../Machine.hpp"
+#include "Check.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Idle skip equivalence: a machine fast-forwarding busy-waits, key waits and
+// zeroed memory must end up exactly like one stepping every instruction,
+// coverage, beeps and frame counts included.
+namespace {
+using c8emu::CPU;
+using c8emu::Machine;
+using c8emu::check::sameState;
+using Coverage = std::array<std::uint8_t, CPU::coverageSize>;
+
+constexpr std::size_t programCount = 3000;
+// Runs are split in chunks, a key goes down after the first one
+constexpr std::size_t chunk = 777;
+constexpr std::array<std::size_t, 7> lengths = {
+    {1, 2, 17, 100, 1000, 12345, 1000000}};
+
+// Delay timer busy-wait around a sound timer and a store
+constexpr std::uint8_t timerWait[] = {
+    0x70, 0x01, 0x61, 0x25, 0xF1, 0x15, 0xF2, 0x18, 0xF3, 0x07, 0x33,
+    0x00, 0x12, 0x08, 0xA4, 0x00, 0xF3, 0x55, 0x72, 0x05, 0x12, 0x00};
+// Key wait with both timers running
+constexpr std::uint8_t keyWait[] = {0x61, 0x07, 0xF1, 0x15, 0xF1,
+                                    0x18, 0xF4, 0x0A, 0x12, 0x00};
+
+struct Run {
+  Machine machine;
+  Coverage coverage;
+  std::size_t beeps;
+};
+
+void start(Run &run, std::vector<std::uint8_t> const &program,
+           std::uint32_t const seed, bool const idleSkip) {
+  run.coverage.fill(0);
+  run.beeps = 0;
+  run.machine.reset(seed);
+  run.machine.load(program.data(), program.size());
+  run.machine.cpu().setCoverage(run.coverage.data());
+  run.machine.cpu().setBeepCallback([&run]() { ++run.beeps; });
+  run.machine.cpu().setIdleSkip(idleSkip);
+}
+
+bool check(Run &skipped, Run &stepped,
+           std::vector<std::uint8_t> const &program, std::uint32_t const seed,
+           std::size_t const cycles) {
+  start(skipped, program, seed, true);
+  start(stepped, program, seed, false);
+  for (std::size_t left = cycles; left > 0;) {
+    std::size_t const n = left < chunk ? left : chunk;
+    skipped.machine.run(n);
+    stepped.machine.run(n);
+    left -= n;
+    skipped.machine.keys()[seed % 16] = true;
+    stepped.machine.keys()[seed % 16] = true;
+  }
+
+  CPU::Stats const &a = skipped.machine.cpu().stats();
+  CPU::Stats const &b = stepped.machine.cpu().stats();
+  if (sameState(skipped.machine.cpu().state(),
+                stepped.machine.cpu().state()) &&
+      skipped.machine.memory() == stepped.machine.memory() &&
+      skipped.machine.gpu().data == stepped.machine.gpu().data &&
+      skipped.coverage == stepped.coverage && skipped.beeps == stepped.beeps &&
+      a.frames == b.frames && a.executed + a.elided == b.executed) {
+    return true;
+  }
+  std::cout << "Idle skip differs (seed " << seed << ", " << cycles
+            << " cycles)" << std::endl;
+  return false;
+}
+} // namespace
+
+int main() {
+  // Coverage maps are too large for the stack
+  std::unique_ptr<Run> skipped = std::make_unique<Run>();
+  std::unique_ptr<Run> stepped = std::make_unique<Run>();
+  std::mt19937 rng(29);
+  std::size_t failures = 0;
+  std::uint64_t elided = 0;
+
+  std::vector<std::uint8_t> const waits[] = {
+      {std::begin(timerWait), std::end(timerWait)},
+      {std::begin(keyWait), std::end(keyWait)}};
+  for (std::size_t const cycles : lengths) {
+    for (std::vector<std::uint8_t> const &program : waits) {
+      if (!check(*skipped, *stepped, program, 1, cycles)) {
+        ++failures;
+      }
+      elided += skipped->machine.cpu().stats().elided;
+    }
+  }
+
+  for (std::uint32_t p = 0; p < programCount; ++p) {
+    std::vector<std::uint8_t> program =
+        c8emu::check::randomProgram(rng, 64 + rng() % 256);
+    // Mostly zeroed programs, so that runs reach long stretches of 0000
+    if (p % 2 == 0) {
+      for (std::uint8_t &b : program) {
+        if (rng() % 4 != 0) {
+          b = 0;
+        }
+      }
+    }
+    if (!check(*skipped, *stepped, program, p, 1 + rng() % 5000)) {
+      ++failures;
+    }
+    elided += skipped->machine.cpu().stats().elided;
+  }
+
+  std::cout << failures << " idle skip mismatches, " << elided
+            << " cycles elided" << std::endl;
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,141 @@
+#include "../Machine.hpp"
+#include "../Trace.hpp"
+#include "Check.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Trace round trip: programs are traced to a file and read back, each record
+// must match what stepping an untraced machine gives. The last trace is then
+// rewritten twice, as is and with one record changed, for c8trace-diff.
+namespace {
+using c8emu::CPU;
+using c8emu::TraceRecord;
+
+constexpr std::size_t programCount = 200;
+constexpr std::size_t cycles = 5000;
+constexpr std::size_t noChange = SIZE_MAX; // For copyTrace()
+
+// V0 += 1, V1 += 3, I = 0x300, jump back: never faults
+constexpr std::uint8_t loop[] = {0x70, 0x01, 0x71, 0x03,
+                                 0xA3, 0x00, 0x12, 0x00};
+
+// Records expected from running the program for `cycles` instructions
+std::vector<TraceRecord>
+expectedRecords(std::vector<std::uint8_t> const &program,
+                std::uint32_t const seed) {
+  c8emu::Machine machine;
+  std::vector<TraceRecord> records;
+
+  machine.reset(seed);
+  machine.load(program.data(), program.size());
+  for (std::size_t c = 0; c < cycles; ++c) {
+    CPU::State const before = machine.cpu().state();
+    if (before.status != CPU::Status::Ok) {
+      break;
+    }
+    machine.cpu().execute();
+    CPU::State const after = machine.cpu().state();
+
+    TraceRecord rec{before.pc, after.opcode, after.I, 0, {{0}}};
+    for (std::size_t i = 0; i < 16; ++i) {
+      if (before.registers[i] != after.registers[i]) {
+        rec.mask = static_cast<std::uint16_t>(rec.mask | (1 << i));
+        rec.values[i] = after.registers[i];
+      }
+    }
+    records.push_back(rec);
+  }
+  return records;
+}
+
+bool roundTrip(std::vector<std::uint8_t> const &program,
+               std::uint32_t const seed, std::string const &file) {
+  c8emu::Machine machine;
+
+  machine.reset(seed);
+  machine.load(program.data(), program.size());
+  {
+    c8emu::TraceWriter writer(file);
+    machine.cpu().setTracer(&writer);
+    machine.run(cycles);
+    machine.cpu().setTracer(nullptr);
+  }
+
+  std::vector<TraceRecord> const expected = expectedRecords(program, seed);
+  c8emu::TraceReader reader(file);
+  TraceRecord rec;
+  std::size_t count = 0;
+  for (; reader.next(rec); ++count) {
+    if (count >= expected.size() || rec != expected[count]) {
+      std::cout << "Record " << count << " differs (seed " << seed << ")"
+                << std::endl;
+      return false;
+    }
+  }
+  if (count != expected.size()) {
+    std::cout << "Trace ends after " << count << " records instead of "
+              << expected.size() << " (seed " << seed << ")" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Writes a copy of a trace, changing the I register of one record
+void copyTrace(std::string const &from, std::string const &to,
+               std::size_t const changed) {
+  c8emu::TraceReader reader(from);
+  c8emu::TraceWriter writer(to);
+  std::array<std::uint8_t, 16> registers{{0}};
+  TraceRecord rec;
+
+  for (std::size_t count = 0; reader.next(rec); ++count) {
+    std::array<std::uint8_t, 16> const before = registers;
+    for (std::size_t i = 0; i < 16; ++i) {
+      if ((rec.mask >> i) & 1) {
+        registers[i] = rec.values[i];
+      }
+    }
+    std::uint16_t const I =
+        count == changed ? static_cast<std::uint16_t>(rec.I ^ 1) : rec.I;
+    writer.record(rec.pc, rec.opcode, I, before, registers);
+  }
+}
+} // namespace
+
+int main(int ac, char *av[]) {
+  if (ac != 5) {
+    std::cout << "Usage: " << *av << " trace copy changed_copy instruction"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    std::mt19937 rng(26);
+    for (std::uint32_t p = 0; p < programCount; ++p) {
+      std::vector<std::uint8_t> const program =
+          c8emu::check::randomProgram(rng, 64 + rng() % 512);
+      if (!roundTrip(program, p, av[1])) {
+        return EXIT_FAILURE;
+      }
+    }
+    if (!roundTrip(std::vector<std::uint8_t>(std::begin(loop), std::end(loop)),
+                   0, av[1])) {
+      return EXIT_FAILURE;
+    }
+
+    copyTrace(av[1], av[2], noChange);
+    copyTrace(av[1], av[3], std::strtoul(av[4], nullptr, 10));
+    std::cout << programCount + 1 << " traces read back" << std::endl;
+    return EXIT_SUCCESS;
+  } catch (std::exception const &e) {
+    std::cerr << e.what() << std::endl;
+  }
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,286 @@
+#include "Harness.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Standalone multi-threaded mutation fuzzer. Each worker owns a Machine which
+// is reset between inputs, inputs reaching new PC/opcode coverage buckets are
+// added to a shared corpus (and optionally written to a directory).
+namespace {
+using byte = std::uint8_t;
+using Input = std::vector<byte>;
+using Coverage = std::array<byte, c8emu::CPU::coverageSize>;
+using Touched = std::array<std::uint16_t, c8emu::CPU::coverageSize>;
+
+constexpr std::size_t maxInputSize = 0x1000 - c8emu::Machine::programStart - 1;
+
+struct Options {
+  std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t seconds = 10;
+  std::string corpusDir;
+  std::vector<std::string> seeds;
+};
+
+class Corpus {
+public:
+  Corpus() : m_mutex(), m_inputs(), m_virgin(), m_edges(0) {
+    for (std::atomic<byte> &bits : m_virgin) {
+      bits.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void add(Input const &input) {
+    auto entry = std::make_shared<Input const>(input);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_inputs.push_back(std::move(entry));
+  }
+
+  // Entries are immutable and shared, picking one doesn't copy it
+  std::shared_ptr<Input const> pick(std::mt19937 &rng) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_inputs[rng() % m_inputs.size()];
+  }
+
+  std::size_t size() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_inputs.size();
+  }
+
+  inline std::size_t edges() const {
+    return m_edges.load(std::memory_order_relaxed);
+  }
+
+  // Merges the bucketed hit counts of a run into the global map, returns
+  // true when the run reached something new. Only the counters the run
+  // touched are looked at.
+  bool merge(Coverage const &map, Touched const &touched,
+             std::size_t const count) {
+    bool found = false;
+
+    for (std::size_t t = 0; t < count; ++t) {
+      std::size_t const i = touched[t];
+      byte const bucket = bucketOf(map[i]);
+      // The plain load only filters out known buckets, the fetch_or decides,
+      // so a bucket two workers reach at once is only new for one of them
+      if ((bucket & ~m_virgin[i].load(std::memory_order_relaxed)) == 0) {
+        continue;
+      }
+      byte const seen = m_virgin[i].fetch_or(bucket, std::memory_order_relaxed);
+      if ((bucket & ~seen) != 0) {
+        if (seen == 0) {
+          m_edges.fetch_add(1, std::memory_order_relaxed);
+        }
+        found = true;
+      }
+    }
+    return found;
+  }
+
+private:
+  std::mutex m_mutex;
+  std::vector<std::shared_ptr<Input const>> m_inputs;
+  std::array<std::atomic<byte>, c8emu::CPU::coverageSize> m_virgin;
+  std::atomic<std::size_t> m_edges;
+
+  // Hit counts are only told apart by order of magnitude, like AFL does
+  static inline byte bucketOf(byte const hits) {
+    if (hits == 0)
+      return 0;
+    if (hits <= 3)
+      return static_cast<byte>(1 << (hits - 1));
+    if (hits <= 7)
+      return 1 << 3;
+    if (hits <= 15)
+      return 1 << 4;
+    if (hits <= 31)
+      return 1 << 5;
+    if (hits <= 127)
+      return 1 << 6;
+    return 1 << 7;
+  }
+};
+
+void mutate(Input &input, Corpus &corpus, std::mt19937 &rng) {
+  std::size_t const count = 1 + rng() % 4;
+
+  for (std::size_t n = 0; n < count; ++n) {
+    if (input.empty()) {
+      input.push_back(static_cast<byte>(rng()));
+      continue;
+    }
+    std::size_t const pos = rng() % input.size();
+
+    switch (rng() % 6) {
+    case 0: // Flip a bit
+      input[pos] = static_cast<byte>(input[pos] ^ (1 << (rng() % 8)));
+      break;
+    case 1: // Random byte
+      input[pos] = static_cast<byte>(rng());
+      break;
+    case 2: // Random instruction, aligned on 2 bytes
+      if (input.size() >= 2) {
+        std::size_t const at = (pos & ~static_cast<std::size_t>(1)) %
+                               (input.size() - 1);
+        input[at] = static_cast<byte>(rng());
+        input[at + 1] = static_cast<byte>(rng());
+      }
+      break;
+    case 3: // Insert an instruction
+      if (input.size() + 2 <= maxInputSize) {
+        input.insert(input.begin() + static_cast<std::ptrdiff_t>(pos),
+                     {static_cast<byte>(rng()), static_cast<byte>(rng())});
+      }
+      break;
+    case 4: // Remove an instruction
+      input.erase(input.begin() + static_cast<std::ptrdiff_t>(pos),
+                  input.begin() + static_cast<std::ptrdiff_t>(
+                                      std::min(pos + 2, input.size())));
+      break;
+    case 5: { // Splice a chunk of another input
+      std::shared_ptr<Input const> const picked = corpus.pick(rng);
+      Input const &other = *picked;
+      if (!other.empty()) {
+        std::size_t const from = rng() % other.size();
+        std::size_t const len = std::min(
+            {std::size_t{1 + rng() % 32}, other.size() - from,
+             input.size() - pos});
+        std::copy(other.begin() + static_cast<std::ptrdiff_t>(from),
+                  other.begin() + static_cast<std::ptrdiff_t>(from + len),
+                  input.begin() + static_cast<std::ptrdiff_t>(pos));
+      }
+      break;
+    }
+    }
+  }
+}
+
+void save(std::string const &dir, Input const &input) {
+  std::uint64_t hash = 0xCBF29CE484222325;
+  for (byte const b : input) {
+    hash = (hash ^ b) * 0x100000001B3;
+  }
+  std::ostringstream name;
+  name << dir << "/" << std::hex << hash;
+  std::ofstream out(name.str(), std::ios::binary);
+  out.write(reinterpret_cast<char const *>(input.data()),
+            static_cast<std::streamsize>(input.size()));
+}
+
+void worker(std::size_t const id, Corpus &corpus, Options const &opt,
+            std::atomic<bool> const &stop, std::atomic<std::uint64_t> &execs) {
+  c8emu::Machine machine;
+  c8emu::CPU &cpu = machine.cpu();
+  Coverage map{};
+  Touched touched;
+  Input input;
+  std::mt19937 rng(static_cast<std::uint32_t>(id * 7919 + 1));
+  std::uint64_t local = 0;
+
+  input.reserve(maxInputSize);
+  cpu.setCoverage(map.data(), touched.data());
+  while (!stop.load(std::memory_order_relaxed)) {
+    std::shared_ptr<Input const> const picked = corpus.pick(rng);
+    input.assign(picked->begin(), picked->end());
+    mutate(input, corpus, rng);
+
+    c8emu::fuzz::runInput(machine, input.data(), input.size());
+    bool const found = corpus.merge(map, touched, cpu.touchedCount());
+    cpu.clearCoverage();
+    if (found) {
+      if (!opt.corpusDir.empty()) {
+        save(opt.corpusDir, input);
+      }
+      corpus.add(input);
+    }
+
+    // Publishing the counter on every run would bounce its cache line
+    if (++local == 256) {
+      execs.fetch_add(local, std::memory_order_relaxed);
+      local = 0;
+    }
+  }
+  execs.fetch_add(local, std::memory_order_relaxed);
+}
+
+bool parseArgs(int ac, char *av[], Options &opt) {
+  for (int i = 1; i < ac; ++i) {
+    if (std::strcmp(av[i], "-j") == 0 && i + 1 < ac) {
+      opt.jobs = std::max(1ul, std::strtoul(av[++i], nullptr, 10));
+    } else if (std::strcmp(av[i], "-t") == 0 && i + 1 < ac) {
+      opt.seconds = std::strtoul(av[++i], nullptr, 10);
+    } else if (std::strcmp(av[i], "-o") == 0 && i + 1 < ac) {
+      opt.corpusDir = av[++i];
+    } else if (av[i][0] != '-') {
+      opt.seeds.emplace_back(av[i]);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+int main(int ac, char *av[]) {
+  Options opt;
+
+  if (!parseArgs(ac, av, opt)) {
+    std::cout << "Usage: " << *av
+              << " [-j jobs] [-t seconds] [-o corpus_dir] [seed ...]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Corpus corpus;
+  for (std::string const &seed : opt.seeds) {
+    std::ifstream file(seed, std::ios::binary);
+    if (!file.is_open()) {
+      std::cerr << "Cannot open file: " << seed << std::endl;
+      return EXIT_FAILURE;
+    }
+    Input input((std::istreambuf_iterator<char>(file)),
+                std::istreambuf_iterator<char>());
+    input.resize(std::min(input.size(), maxInputSize));
+    corpus.add(input);
+  }
+  if (corpus.size() == 0) {
+    corpus.add(Input(2, 0));
+  }
+
+  std::atomic<bool> stop(false);
+  std::atomic<std::uint64_t> execs(0);
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < opt.jobs; ++i) {
+    workers.emplace_back(worker, i, std::ref(corpus), std::cref(opt),
+                         std::cref(stop), std::ref(execs));
+  }
+
+  std::uint64_t last = 0;
+  for (std::size_t sec = 0; sec < opt.seconds; ++sec) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    std::uint64_t const total = execs.load(std::memory_order_relaxed);
+    std::cout << "#" << total << "\texec/s: " << total - last
+              << "\tcorpus: " << corpus.size() << "\tcov: " << corpus.edges()
+              << std::endl;
+    last = total;
+  }
+
+  stop.store(true);
+  for (std::thread &t : workers) {
+    t.join();
+  }
+  return EXIT_SUCCESS;
+}
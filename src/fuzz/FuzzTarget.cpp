@@ -0,0 +1,24 @@
+#include "Harness.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// libFuzzer entry point, build with `make fuzz`. The CPU coverage bitmap is
+// registered as extra counters so libFuzzer also steers towards new
+// PC/opcode pairs of the emulated program, not only new paths in the host
+// code.
+namespace {
+__attribute__((section("__libfuzzer_extra_counters")))
+std::uint8_t coverage[c8emu::CPU::coverageSize];
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const *data,
+                                      std::size_t size);
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const *data,
+                                      std::size_t size) {
+  static c8emu::Machine machine;
+
+  machine.cpu().setCoverage(coverage);
+  c8emu::fuzz::runInput(machine, data, size);
+  return 0;
+}
@@ -0,0 +1,28 @@
+#include "Harness.hpp"
+
+namespace c8emu {
+namespace fuzz {
+
+CPU::Status runInput(Machine &machine, std::uint8_t const *data,
+                     std::size_t const len) {
+  machine.reset(0x8BADF00D);
+  if (!machine.load(data, len)) {
+    return CPU::Status::Ok;
+  }
+
+  // Press each key in turn, then nothing, so key waits and skips are reached
+  CPU::Status status = CPU::Status::Ok;
+  for (std::size_t cycle = 0;
+       cycle < maxCycles && status == CPU::Status::Ok; cycle += keyPeriod) {
+    std::size_t const key = (cycle / keyPeriod) % 17;
+    machine.keys().fill(false);
+    if (key < 16) {
+      machine.keys()[key] = true;
+    }
+    status = machine.run(keyPeriod);
+  }
+  return status;
+}
+
+} // namespace fuzz
+} // namespace c8emu
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../Machine.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace c8emu {
+namespace fuzz {
+// Cycles executed per input, and how often the simulated keypad changes
+constexpr std::size_t maxCycles = 1024;
+constexpr std::size_t keyPeriod = 64;
+
+// Resets the machine, maps the input at 0x200 like Chip8::loadGame() and runs
+// it with a fixed seed and key schedule, so an input always behaves the same.
+CPU::Status runInput(Machine &machine, std::uint8_t const *data,
+                     std::size_t const len);
+} // namespace fuzz
+} // namespace c8emu
@@ -1,19 +1,232 @@
+#include "Batch.hpp"
 #include "Chip8.hpp"
+#include "GridView.hpp"
+#include "Machine.hpp"
+#include "Telemetry.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
+namespace {
+// Cycles run between two looks at the clock in headless mode
+constexpr std::size_t telemetryChunk = 1 << 16;
+
+struct Options {
+  char const *game = nullptr;
+  char const *trace = nullptr;
+  char const *shm = nullptr;
+  std::size_t headlessCycles = 0;
+  std::size_t lanes = 0;
+  bool idleSkip = true;
+  bool terminal = false;
+  bool startupReport = false;
+  std::size_t gridColumns = 0;
+  std::size_t gridRows = 0;
+};
+
+// "8" is an 8x8 grid, "8x4" has 8 columns and 4 rows
+bool parseGrid(char const *arg, Options &opt) {
+  char *end = nullptr;
+
+  // strtoul would accept a sign or spaces, and wrap "-8" around
+  if (!std::isdigit(static_cast<unsigned char>(*arg))) {
+    return false;
+  }
+  opt.gridColumns = std::strtoul(arg, &end, 10);
+  opt.gridRows = opt.gridColumns;
+  if (*end == 'x') {
+    if (!std::isdigit(static_cast<unsigned char>(end[1]))) {
+      return false;
+    }
+    opt.gridRows = std::strtoul(end + 1, &end, 10);
+  }
+  return *end == '\0' && opt.gridColumns != 0 && opt.gridRows != 0 &&
+         opt.gridColumns <= SIZE_MAX / opt.gridRows;
+}
+
+bool parseArgs(int ac, char *av[], Options &opt) {
+  for (int i = 1; i < ac; ++i) {
+    if (std::strcmp(av[i], "--trace") == 0 && i + 1 < ac) {
+      opt.trace = av[++i];
+    } else if (std::strcmp(av[i], "--headless") == 0 && i + 1 < ac) {
+      opt.headlessCycles = std::strtoul(av[++i], nullptr, 10);
+    } else if (std::strcmp(av[i], "--lanes") == 0 && i + 1 < ac) {
+      opt.lanes = std::strtoul(av[++i], nullptr, 10);
+    } else if (std::strcmp(av[i], "--shm") == 0 && i + 1 < ac) {
+      opt.shm = av[++i];
+    } else if (std::strcmp(av[i], "--grid") == 0 && i + 1 < ac) {
+      if (!parseGrid(av[++i], opt)) {
+        std::cerr << "Invalid grid size: " << av[i] << std::endl;
+        return false;
+      }
+    } else if (std::strcmp(av[i], "--startup-report") == 0) {
+      opt.startupReport = true;
+    } else if (std::strcmp(av[i], "--term") == 0) {
+      opt.terminal = true;
+    } else if (std::strcmp(av[i], "--no-idle-skip") == 0) {
+      opt.idleSkip = false;
+    } else if (av[i][0] != '-' && opt.game == nullptr) {
+      opt.game = av[i];
+    } else {
+      return false;
+    }
+  }
+  // The report times the first frame, which those modes never present
+  if (opt.startupReport && (opt.headlessCycles != 0 || opt.gridColumns != 0)) {
+    std::cerr << "--startup-report cannot be used with --headless or --grid"
+              << std::endl;
+    return false;
+  }
+  // The grid has its own window and no trace or shared memory output
+  if (opt.gridColumns != 0 &&
+      (opt.headlessCycles != 0 || opt.trace != nullptr ||
+       opt.shm != nullptr || opt.terminal)) {
+    std::cerr << "--grid cannot be used with --headless, --trace, --shm or "
+                 "--term"
+              << std::endl;
+    return false;
+  }
+  // Lanes have no trace, shared memory or terminal output
+  if (opt.lanes != 0 &&
+      (opt.headlessCycles == 0 || opt.trace != nullptr ||
+       opt.shm != nullptr || opt.terminal)) {
+    std::cerr << "--lanes needs --headless and cannot be used with --trace, "
+                 "--shm or --term"
+              << std::endl;
+    return false;
+  }
+  return opt.game != nullptr;
+}
+
+// Runs copies of the game in lockstep and prints the lane occupancy
+int runBatch(Options const &opt) {
+  c8emu::Batch batch(opt.lanes);
+
+  batch.loadGame(opt.game);
+
+  auto const start = std::chrono::steady_clock::now();
+  c8emu::CPU::Status const status = batch.run(opt.headlessCycles);
+  std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  c8emu::Batch::Stats const &stats = batch.stats();
+  std::uint64_t const laneCycles = stats.vectorLanes + stats.scalarLanes;
+  std::cerr << "status:    " << c8emu::CPU::statusString(status) << std::endl
+            << "lanes:     " << batch.lanes() << std::endl
+            << "cycles:    " << stats.ticks << " per lane" << std::endl
+            << "vector:    " << stats.vectorLanes << " lane cycles in "
+            << stats.vectorIssues << " issues ("
+            << (stats.vectorIssues != 0
+                    ? static_cast<double>(stats.vectorLanes) /
+                          static_cast<double>(stats.vectorIssues)
+                    : 0)
+            << " lanes/issue)" << std::endl
+            << "scalar:    " << stats.scalarLanes << " lane cycles"
+            << std::endl
+            << "occupancy: "
+            << (laneCycles != 0 ? 100 * stats.vectorLanes / laneCycles : 0)
+            << "% vector" << std::endl
+            << "time:      " << elapsed.count() << "s ("
+            << static_cast<double>(laneCycles) / elapsed.count() / 1e6
+            << "M cycles/s)" << std::endl;
+  return status == c8emu::CPU::Status::Ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Runs the game without any frontend and prints a profile of the run
+int runHeadless(Options const &opt) {
+  c8emu::Machine machine;
+  std::unique_ptr<c8emu::TraceWriter> tracer;
+
+  machine.loadGame(opt.game);
+  if (opt.trace != nullptr) {
+    tracer = std::make_unique<c8emu::TraceWriter>(opt.trace);
+    machine.cpu().setTracer(tracer.get());
+  }
+  machine.cpu().setIdleSkip(opt.idleSkip);
+
+  // Runs by chunks, a line of JSON telemetry goes to stdout every second
+  c8emu::Telemetry telemetry;
+  std::size_t left = opt.headlessCycles;
+  c8emu::CPU::Status status = c8emu::CPU::Status::Ok;
+  auto const start = std::chrono::steady_clock::now();
+  auto chunkStart = start;
+  while (left > 0 && status == c8emu::CPU::Status::Ok) {
+    std::size_t const chunk = std::min(left, telemetryChunk);
+    status = machine.run(chunk);
+    left -= chunk;
+
+    auto const now = std::chrono::steady_clock::now();
+    telemetry.addTime(c8emu::Telemetry::Phase::Execute, now - chunkStart);
+    chunkStart = now;
+    if (telemetry.update(now, machine.cpu().stats())) {
+      char line[512];
+      std::size_t const len = telemetry.json(line, sizeof(line));
+      std::fwrite(line, 1, len, stdout);
+      std::fflush(stdout);
+    }
+  }
+  std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  c8emu::CPU::Stats const &stats = machine.cpu().stats();
+  std::uint64_t const cycles = stats.executed + stats.elided;
+  std::cerr << "status:   " << c8emu::CPU::statusString(status) << std::endl
+            << "cycles:   " << cycles << std::endl
+            << "executed: " << stats.executed << std::endl
+            << "elided:   " << stats.elided << " ("
+            << (cycles != 0 ? 100 * stats.elided / cycles : 0) << "%)"
+            << std::endl
+            << "time:     " << elapsed.count() << "s ("
+            << static_cast<double>(cycles) / elapsed.count() / 1e6
+            << "M cycles/s)" << std::endl;
+  return status == c8emu::CPU::Status::Ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+} // namespace
+
 int main(int ac, char *av[]) {
-  if (ac >= 2) {
+  auto const origin = std::chrono::steady_clock::now();
+  Options opt;
+
+  if (parseArgs(ac, av, opt)) {
     try {
-      c8emu::Chip8 chip;
-      chip.loadGame(*(av + 1));
+      if (opt.headlessCycles != 0) {
+        return opt.lanes != 0 ? runBatch(opt) : runHeadless(opt);
+      }
+      if (opt.gridColumns != 0) {
+        c8emu::GridView grid(opt.gridColumns, opt.gridRows);
+        grid.loadGame(opt.game);
+        grid.play();
+        return EXIT_SUCCESS;
+      }
+      c8emu::Chip8 chip(opt.terminal ? c8emu::Chip8::Display::Terminal
+                                     : c8emu::Chip8::Display::Window);
+      chip.loadGame(opt.game);
+      if (opt.trace != nullptr) {
+        chip.trace(opt.trace);
+      }
+      if (opt.shm != nullptr) {
+        chip.share(opt.shm);
+      }
+      if (opt.startupReport) {
+        chip.reportStartup(origin);
+      }
       chip.play();
       return EXIT_SUCCESS;
     } catch (std::exception const &e) {
       std::cerr << e.what() << std::endl;
     }
   } else {
-    std::cout << "Usage: " << *av << " filename" << std::endl;
+    std::cout << "Usage: " << *av
+              << " [--trace file] [--term] [--shm name] [--startup-report] "
+                 "[--grid n[xm]] [--headless cycles [--no-idle-skip] "
+                 "[--lanes n]] filename"
+              << std::endl;
   }
   return EXIT_FAILURE;
 }